@@ -17,6 +17,7 @@
 #include "exceptions.hpp"
 #include "fir/fir.hpp"
 #include "toolchains/compiler.hpp"
+#include "trace.hpp"
 
 namespace fs = std::filesystem;
 
@@ -274,7 +275,10 @@ void generate(const MIR::CFGNode & block, const MIR::State::Persistant & pstate)
         << "build PHONY: phony\n\n"
         << "# Build rules for targets\n\n";
 
-    auto && [rules, tests] = FIR::mir_to_fir(block, pstate);
+    auto && [rules, tests] = [&] {
+        Util::Trace::Scope trace{"backend", "mir_to_fir"};
+        return FIR::mir_to_fir(block, pstate);
+    }();
     for (const auto & r : rules) {
         write_build_rule(r, out);
     }
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2024 Intel Corporation
+
+#include <algorithm>
+#include <functional>
+#include <new>
+
+#include "arena.hpp"
+
+namespace Frontend::AST {
+
+namespace {
+
+/// Size of the blocks allocated by the Arena, unless an allocation is larger
+constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+constexpr std::size_t ALIGNMENT = alignof(void *);
+
+thread_local Arena * current_arena = nullptr;
+
+/**
+ * Header stored before each node
+ *
+ * Records where the node was allocated from, so that delete knows whether
+ * to free it.
+ */
+struct alignas(ALIGNMENT) Header {
+    Arena * arena;
+};
+
+constexpr std::size_t align(std::size_t size) {
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+} // namespace
+
+void * Arena::allocate(std::size_t size) {
+    size = align(size);
+    if (size > remaining) {
+        const std::size_t bsize = std::max(size, BLOCK_SIZE);
+        blocks.push_back(Block{std::make_unique<std::byte[]>(bsize), bsize});
+        next = blocks.back().data.get();
+        remaining = bsize;
+    }
+    void * ptr = next;
+    next += size;
+    remaining -= size;
+    ++count;
+    return ptr;
+}
+
+bool Arena::owns(const void * ptr) const {
+    const auto * p = static_cast<const std::byte *>(ptr);
+    const std::less<const std::byte *> before{};
+    return std::any_of(blocks.begin(), blocks.end(), [&](const Block & b) {
+        return !before(p, b.data.get()) && before(p, b.data.get() + b.size);
+    });
+}
+
+void Arena::reset() {
+    blocks.clear();
+    next = nullptr;
+    remaining = 0;
+    count = 0;
+}
+
+Arena * Arena::current() { return current_arena; }
+
+Arena::Scope::Scope(Arena & a) : previous{current_arena} { current_arena = &a; }
+
+Arena::Scope::~Scope() { current_arena = previous; }
+
+void * ArenaAllocated::operator new(std::size_t size) {
+    Arena * arena = Arena::current();
+    void * mem = arena != nullptr ? arena->allocate(sizeof(Header) + size)
+                                  : ::operator new(sizeof(Header) + size);
+    auto * header = new (mem) Header{arena};
+    return header + 1;
+}
+
+void ArenaAllocated::operator delete(void * ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    auto * header = static_cast<Header *>(ptr) - 1;
+    if (header->arena == nullptr) {
+        ::operator delete(header);
+    }
+}
+
+} // namespace Frontend::AST
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2024 Intel Corporation
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Frontend::AST {
+
+/**
+ * A bump allocator for AST nodes
+ *
+ * Memory is handed out from large blocks, and is only released when the
+ * Arena itself is destroyed. A file's AST is allocated from one Arena, which
+ * is owned by the CodeBlock for that file, so parsing does one allocation
+ * per block rather than per node, and the whole tree is freed at once.
+ */
+class Arena {
+  public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena & operator=(const Arena &) = delete;
+    ~Arena() = default;
+
+    /**
+     * Get memory from the arena
+     *
+     * Memory is aligned for anything up to alignof(void *).
+     */
+    void * allocate(std::size_t size);
+
+    /// The number of allocations made from this Arena since it was last reset
+    std::size_t allocations() const { return count; }
+
+    /// Was this memory allocated from this Arena?
+    bool owns(const void *) const;
+
+    /**
+     * Release all of the memory allocated from this Arena
+     *
+     * Every node allocated from the Arena must already have been destroyed.
+     */
+    void reset();
+
+    /// The Arena that nodes created on this thread are allocated from, if any
+    static Arena * current();
+
+    /**
+     * Make an Arena the current Arena for this thread, until this goes out
+     * of scope
+     */
+    class Scope {
+      public:
+        explicit Scope(Arena &);
+        Scope(const Scope &) = delete;
+        ~Scope();
+
+      private:
+        Arena * previous;
+    };
+
+  private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks{};
+    std::byte * next = nullptr;
+    std::size_t remaining = 0;
+    std::size_t count = 0;
+};
+
+/**
+ * Base class for AST nodes, which allocates them from the current Arena
+ *
+ * If there is no current Arena the node is allocated from the heap as usual.
+ * Deleting a node allocated from an Arena runs its destructor but does not
+ * free the memory, that happens when the Arena is destroyed. Therefore the
+ * Arena must outlive the nodes allocated from it.
+ */
+class ArenaAllocated {
+  public:
+    static void * operator new(std::size_t);
+    static void operator delete(void *) noexcept;
+};
+
+} // namespace Frontend::AST
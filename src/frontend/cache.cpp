@@ -0,0 +1,590 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2024 Intel Corporation
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <type_traits>
+#include <variant>
+
+#include <unistd.h>
+
+#include "cache.hpp"
+
+namespace Frontend {
+
+namespace {
+
+/// Changed whenever the layout of entries changes
+constexpr std::uint32_t FORMAT_VERSION = 2;
+
+constexpr std::string_view MAGIC{"MPPAST"};
+
+/// A 64 bit FNV-1a hash of the file contents, used to name entries
+std::uint64_t hash(std::string_view text) {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char c : text) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/// Get the index of std::unique_ptr<T> in a variant
+template <typename V, typename T, std::size_t I = 0> constexpr std::uint64_t variant_index() {
+    if constexpr (std::is_same_v<std::variant_alternative_t<I, V>, std::unique_ptr<T>>) {
+        return I;
+    } else {
+        return variant_index<V, T, I + 1>();
+    }
+}
+
+/// Raised when an entry is truncated or malformed, the entry is then ignored
+class BadEntry {};
+
+/**
+ * Write an AST in the cache format
+ *
+ * Integers are written as LEB128 varints, and every expression and statement
+ * is prefixed by its index in the ExpressionV or StatementV variant.
+ */
+class Writer {
+  public:
+    Writer(std::string & o, std::string_view text) : out{o}, source{text} {};
+
+    void uint(std::uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    void sint(std::int64_t v) {
+        // zigzag encode so that small negative numbers are small
+        uint((static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63));
+    }
+
+    void bytes(std::string_view v) {
+        uint(v.size());
+        out.append(v);
+    }
+
+    void string(std::string_view v) {
+        // If the string is a view of the file just store where it is,
+        // otherwise it was unescaped and has to be stored in full
+        if (v.data() >= source.data() && v.data() + v.size() <= source.data() + source.size()) {
+            uint(0);
+            uint(static_cast<std::uint64_t>(v.data() - source.data()));
+            uint(v.size());
+        } else {
+            uint(1);
+            bytes(v);
+        }
+    }
+
+    void loc(const AST::Location & l) {
+        uint(static_cast<std::uint64_t>(l.line_start));
+        uint(static_cast<std::uint64_t>(l.column_start));
+        uint(static_cast<std::uint64_t>(l.line_end));
+        uint(static_cast<std::uint64_t>(l.column_end));
+    }
+
+    void expr(const AST::ExpressionV & e) {
+        uint(e.index());
+        std::visit(*this, e);
+    }
+
+    void exprs(const AST::ExpressionList & l) {
+        uint(l.size());
+        for (const auto & e : l) {
+            expr(e);
+        }
+    }
+
+    template <typename T> void keywords(const T & kw) {
+        uint(kw.size());
+        for (const auto & [k, v] : kw) {
+            expr(k);
+            expr(v);
+        }
+    }
+
+    void block(const AST::CodeBlock & b) {
+        uint(b.statements.size());
+        for (const auto & s : b.statements) {
+            uint(s.index());
+            std::visit(*this, s);
+        }
+    }
+
+    void operator()(const std::unique_ptr<AST::Number> & e) {
+        sint(e->value);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::Boolean> & e) {
+        uint(e->value ? 1 : 0);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::String> & e) {
+        string(e->value);
+        uint((e->is_triple ? 1 : 0) | (e->is_fstring ? 2 : 0));
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::Identifier> & e) {
+        string(e->value);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::Subscript> & e) {
+        expr(e->lhs);
+        expr(e->rhs);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::UnaryExpression> & e) {
+        uint(static_cast<std::uint64_t>(e->op));
+        expr(e->rhs);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::MultiplicativeExpression> & e) {
+        expr(e->lhs);
+        uint(static_cast<std::uint64_t>(e->op));
+        expr(e->rhs);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::AdditiveExpression> & e) {
+        expr(e->lhs);
+        uint(static_cast<std::uint64_t>(e->op));
+        expr(e->rhs);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::Relational> & e) {
+        expr(e->lhs);
+        uint(static_cast<std::uint64_t>(e->op));
+        expr(e->rhs);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::FunctionCall> & e) {
+        expr(e->held);
+        exprs(e->args->positional);
+        keywords(e->args->keyword);
+        loc(e->args->loc);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::GetAttribute> & e) {
+        expr(e->holder);
+        expr(e->held);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::Array> & e) {
+        exprs(e->elements);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::Dict> & e) {
+        keywords(e->elements);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::Ternary> & e) {
+        expr(e->condition);
+        expr(e->lhs);
+        expr(e->rhs);
+        loc(e->loc);
+    }
+
+    void operator()(const std::unique_ptr<AST::Statement> & s) { expr(s->expr); }
+
+    void operator()(const std::unique_ptr<AST::Assignment> & s) {
+        expr(s->lhs);
+        uint(static_cast<std::uint64_t>(s->op));
+        expr(s->rhs);
+    }
+
+    void operator()(const std::unique_ptr<AST::IfStatement> & s) {
+        expr(s->ifblock.condition);
+        block(*s->ifblock.block);
+        uint(s->efblock.size());
+        for (const auto & e : s->efblock) {
+            expr(e.condition);
+            block(*e.block);
+        }
+        uint(s->eblock.block ? 1 : 0);
+        if (s->eblock.block) {
+            block(*s->eblock.block);
+        }
+    }
+
+    void operator()(const std::unique_ptr<AST::ForeachStatement> & s) {
+        string(s->id.value);
+        loc(s->id.loc);
+        uint(s->id2 ? 1 : 0);
+        if (s->id2) {
+            string(s->id2->value);
+            loc(s->id2->loc);
+        }
+        expr(s->expr);
+        block(*s->block);
+    }
+
+    void operator()(const std::unique_ptr<AST::Break> &) {}
+
+    void operator()(const std::unique_ptr<AST::Continue> &) {}
+
+  private:
+    std::string & out;
+    std::string_view source;
+};
+
+/// Read an AST written by the Writer
+class Reader {
+  public:
+    Reader(std::string_view in, Source & src, const std::string & fname)
+        : data{in}, source{src}, filename{fname} {};
+
+    std::uint64_t get() {
+        std::uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (pos >= data.size()) {
+                throw BadEntry{};
+            }
+            const auto byte = static_cast<unsigned char>(data[pos++]);
+            v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return v;
+            }
+        }
+        throw BadEntry{};
+    }
+
+    std::int64_t get_signed() {
+        const std::uint64_t v = get();
+        return static_cast<std::int64_t>((v >> 1) ^ (~(v & 1) + 1));
+    }
+
+    /// Get an enum value, checking that it's in range
+    template <typename T> T get_enum(T last) {
+        const auto v = get();
+        if (v > static_cast<std::uint64_t>(last)) {
+            throw BadEntry{};
+        }
+        return static_cast<T>(v);
+    }
+
+    std::string_view get_bytes(std::size_t size) {
+        if (size > data.size() - pos) {
+            throw BadEntry{};
+        }
+        auto v = data.substr(pos, size);
+        pos += size;
+        return v;
+    }
+
+    std::string_view get_string() {
+        const auto kind = get();
+        if (kind == 0) {
+            const auto text = source.contents();
+            const auto offset = get();
+            const auto size = get();
+            if (offset > text.size() || size > text.size() - offset) {
+                throw BadEntry{};
+            }
+            return text.substr(offset, size);
+        }
+        if (kind == 1) {
+            return source.intern(std::string{get_bytes(get())});
+        }
+        throw BadEntry{};
+    }
+
+    location get_location() {
+        location l{&filename};
+        l.begin.line = static_cast<int>(get());
+        l.begin.column = static_cast<int>(get());
+        l.end.line = static_cast<int>(get());
+        l.end.column = static_cast<int>(get());
+        return l;
+    }
+
+    AST::ExpressionList get_expressions() {
+        AST::ExpressionList l{};
+        for (auto n = get(); n > 0; --n) {
+            l.emplace_back(get_expression());
+        }
+        return l;
+    }
+
+    AST::KeywordList get_keywords() {
+        AST::KeywordList l{};
+        for (auto n = get(); n > 0; --n) {
+            auto k = get_expression();
+            auto v = get_expression();
+            l.emplace_back(std::move(k), std::move(v));
+        }
+        return l;
+    }
+
+    AST::ExpressionV get_expression() {
+        using namespace AST;
+        switch (get()) {
+            case variant_index<ExpressionV, AdditiveExpression>(): {
+                auto l = get_expression();
+                auto op = get_enum(AddOp::SUB);
+                auto r = get_expression();
+                auto loc = get_location();
+                return std::make_unique<AdditiveExpression>(std::move(l), op, std::move(r), loc);
+            }
+            case variant_index<ExpressionV, Boolean>(): {
+                const bool v = get() != 0;
+                return std::make_unique<Boolean>(v, get_location());
+            }
+            case variant_index<ExpressionV, Identifier>(): {
+                auto v = get_string();
+                return std::make_unique<Identifier>(v, get_location());
+            }
+            case variant_index<ExpressionV, MultiplicativeExpression>(): {
+                auto l = get_expression();
+                auto op = get_enum(MulOp::MOD);
+                auto r = get_expression();
+                auto loc = get_location();
+                return std::make_unique<MultiplicativeExpression>(std::move(l), op, std::move(r),
+                                                                  loc);
+            }
+            case variant_index<ExpressionV, UnaryExpression>(): {
+                auto op = get_enum(UnaryOp::NOT);
+                auto r = get_expression();
+                auto loc = get_location();
+                return std::make_unique<UnaryExpression>(op, std::move(r), loc);
+            }
+            case variant_index<ExpressionV, Number>(): {
+                const auto v = get_signed();
+                return std::make_unique<Number>(v, get_location());
+            }
+            case variant_index<ExpressionV, String>(): {
+                auto v = get_string();
+                const auto flags = get();
+                return std::make_unique<String>(v, (flags & 1) != 0, (flags & 2) != 0,
+                                                get_location());
+            }
+            case variant_index<ExpressionV, Subscript>(): {
+                auto l = get_expression();
+                auto r = get_expression();
+                auto loc = get_location();
+                return std::make_unique<Subscript>(std::move(l), std::move(r), loc);
+            }
+            case variant_index<ExpressionV, Relational>(): {
+                auto l = get_expression();
+                auto op = get_enum(RelationalOp::NOT_IN);
+                auto r = get_expression();
+                auto loc = get_location();
+                return std::make_unique<Relational>(std::move(l), op, std::move(r), loc);
+            }
+            case variant_index<ExpressionV, FunctionCall>(): {
+                auto held = get_expression();
+                auto pos = get_expressions();
+                auto kw = get_keywords();
+                auto aloc = get_location();
+                auto args = std::make_unique<Arguments>(std::move(pos), std::move(kw), aloc);
+                auto loc = get_location();
+                return std::make_unique<FunctionCall>(std::move(held), std::move(args), loc);
+            }
+            case variant_index<ExpressionV, GetAttribute>(): {
+                auto holder = get_expression();
+                auto held = get_expression();
+                auto loc = get_location();
+                return std::make_unique<GetAttribute>(std::move(holder), std::move(held), loc);
+            }
+            case variant_index<ExpressionV, Array>(): {
+                auto elements = get_expressions();
+                auto loc = get_location();
+                return std::make_unique<Array>(std::move(elements), loc);
+            }
+            case variant_index<ExpressionV, Dict>(): {
+                auto kw = get_keywords();
+                auto loc = get_location();
+                return std::make_unique<Dict>(std::move(kw), loc);
+            }
+            case variant_index<ExpressionV, Ternary>(): {
+                auto c = get_expression();
+                auto l = get_expression();
+                auto r = get_expression();
+                auto loc = get_location();
+                return std::make_unique<Ternary>(std::move(c), std::move(l), std::move(r), loc);
+            }
+            default:
+                throw BadEntry{};
+        }
+    }
+
+    std::unique_ptr<AST::CodeBlock> get_block() {
+        auto block = std::make_unique<AST::CodeBlock>();
+        for (auto n = get(); n > 0; --n) {
+            block->statements.emplace_back(get_statement());
+        }
+        return block;
+    }
+
+    AST::StatementV get_statement() {
+        using namespace AST;
+        switch (get()) {
+            case variant_index<StatementV, Statement>():
+                return std::make_unique<Statement>(get_expression());
+            case variant_index<StatementV, Assignment>(): {
+                auto l = get_expression();
+                auto op = get_enum(AssignOp::MOD_EQUAL);
+                auto r = get_expression();
+                return std::make_unique<Assignment>(std::move(l), op, std::move(r));
+            }
+            case variant_index<StatementV, IfStatement>(): {
+                auto cond = get_expression();
+                IfBlock ifb{std::move(cond), get_block()};
+                std::vector<ElifBlock> efb{};
+                for (auto n = get(); n > 0; --n) {
+                    auto econd = get_expression();
+                    efb.emplace_back(std::move(econd), get_block());
+                }
+                ElseBlock eb{};
+                if (get() != 0) {
+                    eb = ElseBlock{get_block()};
+                }
+                return std::make_unique<IfStatement>(std::move(ifb), std::move(efb), std::move(eb));
+            }
+            case variant_index<StatementV, ForeachStatement>(): {
+                auto v = get_string();
+                Identifier id{v, get_location()};
+                if (get() != 0) {
+                    auto v2 = get_string();
+                    Identifier id2{v2, get_location()};
+                    auto expr = get_expression();
+                    return std::make_unique<ForeachStatement>(std::move(id), std::move(id2),
+                                                              std::move(expr), get_block());
+                }
+                auto expr = get_expression();
+                return std::make_unique<ForeachStatement>(std::move(id), std::move(expr),
+                                                          get_block());
+            }
+            case variant_index<StatementV, Break>():
+                return std::make_unique<Break>();
+            case variant_index<StatementV, Continue>():
+                return std::make_unique<Continue>();
+            default:
+                throw BadEntry{};
+        }
+    }
+
+    bool done() const { return pos == data.size(); }
+
+  private:
+    std::string_view data;
+    std::size_t pos = 0;
+    Source & source;
+    const std::string & filename;
+};
+
+} // namespace
+
+std::filesystem::path Cache::entry(const Source & src) const {
+    std::ostringstream name{};
+    name << std::hex << hash(src.contents()) << ".ast";
+    return dir / name.str();
+}
+
+std::unique_ptr<AST::CodeBlock> Cache::load(Source & src, const std::string & fname) const {
+    const auto path = entry(src);
+    std::ifstream in{path, std::ios_base::in | std::ios_base::binary};
+    if (!in) {
+        return nullptr;
+    }
+    const std::string data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+    Reader reader{data, src, AST::Files::intern(fname)};
+    try {
+        // Check that this was written by the same version of Meson++, for
+        // exactly this file, and not one whose contents hash the same
+        if (reader.get_bytes(MAGIC.size()) != MAGIC || reader.get() != FORMAT_VERSION ||
+            reader.get_bytes(reader.get()) != version ||
+            reader.get_bytes(reader.get()) != src.contents()) {
+            return nullptr;
+        }
+        auto block = reader.get_block();
+        if (!reader.done()) {
+            return nullptr;
+        }
+        keep(path);
+        return block;
+    } catch (BadEntry &) {
+        return nullptr;
+    }
+}
+
+void Cache::store(const Source & src, const AST::CodeBlock & block) const {
+    const auto text = src.contents();
+    std::string data{MAGIC};
+    Writer writer{data, text};
+    writer.uint(FORMAT_VERSION);
+    writer.bytes(version);
+    writer.bytes(text);
+    writer.block(block);
+
+    std::error_code ec{};
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        return;
+    }
+
+    // Write to a temporary file and then rename it, so that a reader never
+    // sees a partial entry. The name is unique to this write, even if another
+    // thread, or another configure of the same build directory, is writing
+    // the same entry.
+    static std::atomic<std::uint64_t> writes{0};
+    const auto path = entry(src);
+    auto tmp = path;
+    tmp += "." + std::to_string(getpid()) + "." + std::to_string(writes++);
+    {
+        std::ofstream out{tmp, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc};
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (!ec) {
+        keep(path);
+    }
+}
+
+void Cache::keep(const std::filesystem::path & path) const {
+    std::lock_guard<std::mutex> guard{lock};
+    used.emplace(path.filename().string());
+}
+
+void Cache::prune() const {
+    std::lock_guard<std::mutex> guard{lock};
+
+    // Pruning is only housekeeping, so stop quietly on any error rather than
+    // letting the throwing overloads fail the configure
+    std::error_code ec{};
+    for (std::filesystem::directory_iterator it{dir, ec}, end{}; !ec && it != end;
+         it.increment(ec)) {
+        if (used.count(it->path().filename().string()) == 0) {
+            std::error_code remove_ec{};
+            std::filesystem::remove(it->path(), remove_ec);
+        }
+    }
+}
+
+} // namespace Frontend
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2024 Intel Corporation
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "node.hpp"
+#include "source.hpp"
+
+namespace Frontend {
+
+/**
+ * An on disk cache of parsed files
+ *
+ * Each entry is the AST of a single file, before any `subdir()` calls are
+ * replaced, stored in a compact binary form. Entries are named by a hash of
+ * the file's contents, and hold a copy of the contents and the Meson++
+ * version that wrote them, so an entry is only used if the file is unchanged
+ * and the same version of Meson++ is reading it, even if another file's
+ * contents hash the same.
+ *
+ * Strings that appear verbatim in the file are stored as offsets into it, so
+ * a loaded AST is still a view of the Source just like a freshly parsed one.
+ *
+ * Every edit to a file produces a new entry, so the entries that were loaded
+ * or stored are recorded, and `prune()` removes all of the others.
+ */
+class Cache {
+  public:
+    /**
+     * @param dir The directory to store entries in, this will be created if
+     *            it doesn't exist
+     * @param version The Meson++ version
+     */
+    Cache(std::filesystem::path dir, std::string version)
+        : dir{std::move(dir)}, version{std::move(version)} {};
+
+    /**
+     * Load the AST for a Source
+     *
+     * This must be called with the arena the nodes should be allocated from
+     * current.
+     *
+     * @param src The Source to load the AST for
+     * @param filename The name of the file the Source was read from
+     * @return The AST, or nullptr if there is no valid entry
+     */
+    std::unique_ptr<AST::CodeBlock> load(Source & src, const std::string & filename) const;
+
+    /**
+     * Store the AST for a Source
+     *
+     * The cache is only an optimization, so failing to write an entry is not
+     * an error.
+     */
+    void store(const Source & src, const AST::CodeBlock & block) const;
+
+    /**
+     * Remove every entry that has not been loaded or stored through this Cache
+     *
+     * This should be called once all files have been parsed, so that entries
+     * for old versions of files, and for files that are no longer part of
+     * the project, do not build up.
+     */
+    void prune() const;
+
+  private:
+    std::filesystem::path entry(const Source & src) const;
+
+    /// Record that an entry is still in use, so it is not pruned
+    void keep(const std::filesystem::path & path) const;
+
+    const std::filesystem::path dir;
+    const std::string version;
+
+    /// The file names of the entries in use, files are parsed from many threads
+    mutable std::mutex lock{};
+    mutable std::unordered_set<std::string> used{};
+};
+
+} // namespace Frontend
@@ -1,55 +1,253 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright © 2021-2024 Intel Corporation
 
-#include <fstream>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
 
+#include "arena.hpp"
+#include "cache.hpp"
 #include "driver.hpp"
 #include "node.hpp"
 #include "node_visitors.hpp"
 #include "parser.yy.hpp"
 #include "scanner.hpp"
+#include "source.hpp"
+#include "trace.hpp"
 
 namespace Frontend {
 
-std::unique_ptr<AST::CodeBlock> Driver::parse(const std::string & s) {
-    name = s;
+namespace {
 
-    std::ifstream stream{s, std::ios_base::in | std::ios_base::binary};
+/**
+ * Parse a single file, without replacing any subdir() calls
+ *
+ * If a cache is provided the file is loaded from it if possible, and stored
+ * in it if not.
+ */
+std::unique_ptr<AST::CodeBlock> parse_block(std::shared_ptr<Source> src, const std::string & name,
+                                            const Cache * cache) {
+    Util::Trace::Scope trace{"frontend", [&] { return "parse " + name; }};
 
-    return parse(stream);
-};
+    // All of the nodes for this file are allocated from one arena, this is
+    // declared first so that it outlives any nodes left on the parser's stack
+    // if parsing fails.
+    auto arena = std::make_unique<AST::Arena>();
+    AST::Arena::Scope scope{*arena};
 
-std::unique_ptr<AST::CodeBlock> Driver::parse(std::istream & iss) {
-    auto block = std::make_unique<Frontend::AST::CodeBlock>();
-    auto scanner = std::make_unique<Frontend::Scanner>(&iss, name);
-    auto parser = std::make_unique<Frontend::Parser>(*scanner, block);
+    std::unique_ptr<AST::CodeBlock> block = cache ? cache->load(*src, name) : nullptr;
+    if (!block) {
+        block = std::make_unique<Frontend::AST::CodeBlock>();
+        auto scanner = std::make_unique<Frontend::Scanner>(*src, name);
+        auto parser = std::make_unique<Frontend::Parser>(*scanner, block, nullptr);
 
-    int res = parser->parse();
-    if (res != 0) {
-        throw std::exception{};
+        int res = parser->parse();
+        if (res != 0) {
+            throw std::exception{};
+        }
+
+        if (cache) {
+            cache->store(*src, *block);
+        }
     }
 
-    std::vector<AST::StatementV> new_stmts{};
+    // The block holds views into the source, and nodes allocated from the
+    // arena, so it has to keep them alive
+    block->sources.emplace_back(std::move(src));
+    block->arenas.emplace_back(std::move(arena));
 
-    // Walk over all of the statements, replacing any subdir() calls with new
-    AST::SubdirVisitor sv{};
-    for (auto && stmt : block->statements) {
-        auto res = std::visit(sv, stmt);
-
-        // If we have a value that means that a `subdir()` call was
-        // encounted, we then wnat to add the staements from that call into
-        // our new statements instead of the current `subdir()` call.
-        // Otherwise just move the statement.
-        if (res.has_value()) {
-            auto & v = res.value();
-            std::move(v->statements.begin(), v->statements.end(), std::back_inserter(new_stmts));
-        } else {
-            new_stmts.emplace_back(std::move(stmt));
+    return block;
+}
+
+std::unique_ptr<AST::CodeBlock> parse_block(const std::filesystem::path & p, const Cache * cache) {
+    std::string name = p;
+    return parse_block(std::make_shared<Source>(name), name, cache);
+}
+
+/**
+ * Parse all of the files reachable through subdir() calls from the root
+ * block, using a pool of threads.
+ *
+ * Each file is parsed once, the resulting blocks still contain their subdir()
+ * calls, which are resolved from the returned map.
+ */
+AST::ParsedFiles parse_subdirs(const AST::CodeBlock & root, unsigned jobs, const Cache * cache) {
+    AST::ParsedFiles parsed{};
+    std::deque<std::filesystem::path> todo{};
+    std::set<std::filesystem::path> seen{};
+    std::exception_ptr error = nullptr;
+    unsigned running = 0;
+    std::mutex lock{};
+    std::condition_variable cond{};
+
+    // Add new work, the lock must be held by the caller
+    auto add_work = [&](const AST::CodeBlock & block) {
+        std::vector<std::filesystem::path> files{};
+        AST::find_subdir_files(block, files);
+        for (auto && f : files) {
+            if (seen.emplace(f).second) {
+                todo.emplace_back(std::move(f));
+            }
+        }
+    };
+
+    auto worker = [&]() {
+        Util::Trace::set_thread_name("parser");
+        std::unique_lock<std::mutex> guard{lock};
+        while (true) {
+            cond.wait(guard, [&] { return !todo.empty() || running == 0 || error; });
+            if (error || todo.empty()) {
+                break;
+            }
+
+            auto p = std::move(todo.front());
+            todo.pop_front();
+            ++running;
+            guard.unlock();
+
+            std::unique_ptr<AST::CodeBlock> block{};
+            std::exception_ptr err = nullptr;
+            try {
+                block = parse_block(p, cache);
+            } catch (...) {
+                err = std::current_exception();
+            }
+
+            guard.lock();
+            --running;
+            if (err) {
+                if (!error) {
+                    error = err;
+                }
+            } else {
+                try {
+                    add_work(*block);
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                parsed[p] = std::move(block);
+            }
+            cond.notify_all();
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        add_work(root);
+    }
+
+    if (todo.empty()) {
+        return parsed;
+    }
+
+    std::vector<std::thread> threads{};
+    for (unsigned i = 0; i < jobs; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto & t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    return parsed;
+}
+
+void stream_file(const std::filesystem::path & p, const AST::StatementSink & sink,
+                 const Cache * cache);
+
+/**
+ * Pass a top level statement to the sink
+ *
+ * A subdir() call is replaced by streaming the file it references, subdir()
+ * calls inside of an if statement are replaced in the statement.
+ */
+void stream_statement(AST::StatementV stmt, const AST::StatementSink & sink, const Cache * cache) {
+    if (const auto * s = std::get_if<std::unique_ptr<AST::Statement>>(&stmt)) {
+        if (auto p = AST::subdir_file(**s)) {
+            stream_file(p.value(), sink, cache);
+            return;
         }
     }
+    std::visit(AST::SubdirVisitor{nullptr, cache}, stmt);
+    sink(std::move(stmt));
+}
+
+/**
+ * Parse a file, passing each top level statement to the sink as soon as it
+ * has been parsed
+ *
+ * If the file is in the cache it is loaded from there, but files that are
+ * streamed are not added to the cache, as the whole AST is never available.
+ */
+void stream_file(const std::filesystem::path & p, const AST::StatementSink & sink,
+                 const Cache * cache) {
+    const std::string name = p;
+    // This includes the time spent lowering the statements, and any subdirs
+    Util::Trace::Scope trace{"frontend", [&] { return "stream " + name; }};
+    Source src{name};
+
+    // Only one top level statement is alive at a time, so once it has been
+    // consumed everything in the arena is dead and the memory can be reused
+    // for the next statement.
+    AST::Arena arena{};
+    AST::Arena::Scope scope{arena};
+
+    if (cache) {
+        if (auto block = cache->load(src, name)) {
+            for (auto & stmt : block->statements) {
+                stream_statement(std::move(stmt), sink, cache);
+            }
+            return;
+        }
+    }
+
+    const AST::StatementSink consume = [&](AST::StatementV stmt) {
+        stream_statement(std::move(stmt), sink, cache);
+        arena.reset();
+    };
+
+    auto block = std::make_unique<AST::CodeBlock>();
+    Scanner scanner{src, name};
+    Parser parser{scanner, block, &consume};
+    if (parser.parse() != 0) {
+        throw std::exception{};
+    }
+}
+
+} // namespace
 
-    block->statements = std::move(new_stmts);
+std::unique_ptr<AST::CodeBlock> Driver::parse(const std::string & s) {
+    name = s;
+    return expand(parse_block(std::make_shared<Source>(s), name, cache));
+};
+
+void Driver::parse(const std::string & s, const AST::StatementSink & sink) {
+    name = s;
+    stream_file(s, sink, cache);
+}
+
+std::unique_ptr<AST::CodeBlock> Driver::parse(std::istream & iss) {
+    return expand(parse_block(std::make_shared<Source>(iss), name, cache));
+};
+
+std::unique_ptr<AST::CodeBlock> Driver::expand(std::unique_ptr<AST::CodeBlock> block) const {
+    // Walk over all of the statements, replacing any subdir() calls with new
+    if (jobs > 1) {
+        auto parsed = parse_subdirs(*block, jobs, cache);
+        AST::replace_subdirs(*block, AST::SubdirVisitor{&parsed, cache});
+    } else {
+        AST::replace_subdirs(*block, AST::SubdirVisitor{nullptr, cache});
+    }
 
     return block;
 };
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 
+#include "cache.hpp"
 #include "parser.yy.hpp"
 
 namespace Frontend {
@@ -15,12 +16,56 @@ namespace Frontend {
 class Driver {
   public:
     Driver() = default;
+
+    /**
+     * Create a driver that may use threads to parse subdirectories
+     *
+     * @param jobs The maximum number of files to parse at the same time
+     */
+    explicit Driver(unsigned jobs) : jobs{jobs} {};
     ~Driver() = default;
 
     std::unique_ptr<AST::CodeBlock> parse(std::istream &);
     std::unique_ptr<AST::CodeBlock> parse(const std::string &);
 
+    /**
+     * Parse a file, passing each top level statement to a sink as soon as it
+     * has been parsed, rather than building the whole tree
+     *
+     * `subdir()` calls are replaced by the statements of the file they
+     * reference, so the sink receives the same statements, in the same order,
+     * as parse() would return. Only one statement is alive at a time: each
+     * statement must be destroyed before the sink returns, after which its
+     * memory is reused.
+     *
+     * This never uses threads, and files that are parsed are not added to the
+     * cache.
+     */
+    void parse(const std::string &, const AST::StatementSink &);
+
     std::string name;
+
+    /**
+     * How many files may be parsed at once
+     *
+     * When this is greater than 1 the files referenced by `subdir()` calls
+     * are found and parsed ahead of time by a pool of threads, then replaced
+     * in statement order, so the resulting tree is the same as a serial parse.
+     */
+    unsigned jobs = 1;
+
+    /**
+     * A cache of previously parsed files
+     *
+     * If this is set files that are unchanged since they were cached are
+     * loaded from it rather than parsed, and files that are parsed are added
+     * to it.
+     */
+    const Cache * cache = nullptr;
+
+  private:
+    /// Replace the subdir() calls in a freshly parsed block
+    std::unique_ptr<AST::CodeBlock> expand(std::unique_ptr<AST::CodeBlock>) const;
 };
 
 } // namespace Frontend
@@ -1,6 +1,10 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright © 2021-2024 Intel Corporation
 
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <mutex>
 #include <numeric>
 
 #include "node.hpp"
@@ -10,6 +14,82 @@ namespace Frontend::AST {
 
 namespace {
 
+/**
+ * File names indexed by id
+ *
+ * The names are stored in chunks, each twice the size of the one before it,
+ * which are never moved or freed. Only the chunk pointers are shared, and
+ * each is set once, so a name can be read without a lock once its id has been
+ * handed out. A std::deque would not do, as it reallocates its index of
+ * blocks when it grows.
+ */
+class Names {
+  public:
+    Names() = default;
+    Names(const Names &) = delete;
+    Names & operator=(const Names &) = delete;
+
+    ~Names() {
+        for (auto & c : chunks) {
+            delete[] c.load(std::memory_order_relaxed);
+        }
+    }
+
+    const std::string & operator[](FileId id) const {
+        const auto [chunk, offset] = locate(id);
+        return chunks[chunk].load(std::memory_order_acquire)[offset];
+    }
+
+    FileId size() const { return count; }
+
+    /// Add a name, the table lock must be held
+    const std::string & add(const std::string & name) {
+        const auto [chunk, offset] = locate(count);
+        std::string * c = chunks[chunk].load(std::memory_order_relaxed);
+        if (c == nullptr) {
+            c = new std::string[first << chunk];
+            chunks[chunk].store(c, std::memory_order_release);
+        }
+        ++count;
+        return c[offset] = name;
+    }
+
+  private:
+    static constexpr std::size_t first = 64;
+
+    /// Find the chunk holding an id, and its offset in that chunk
+    static std::pair<std::size_t, std::size_t> locate(FileId id) {
+        std::size_t chunk = 0;
+        std::size_t start = 0;
+        while (id - start >= first << chunk) {
+            start += first << chunk;
+            ++chunk;
+        }
+        return {chunk, id - start};
+    }
+
+    /// Enough chunks for every FileId
+    std::array<std::atomic<std::string *>, 27> chunks{};
+
+    FileId count = 0;
+};
+
+struct FileTable {
+    std::mutex lock{};
+
+    Names entries{};
+
+    std::unordered_map<std::string, FileId> ids{};
+
+    /// The id of each stored name, by the address of the name
+    std::unordered_map<const std::string *, FileId> addresses{};
+};
+
+FileTable & file_table() {
+    static FileTable table{};
+    return table;
+}
+
 struct ExprStringVisitor {
     std::string operator()(const std::unique_ptr<String> & s) { return s->as_string(); };
 
@@ -112,21 +192,58 @@ std::string stringlistify(const ExpressionList & expressions) {
 
 } // namespace
 
+const std::string & Files::intern(const std::string & name) {
+    auto & table = file_table();
+    std::lock_guard<std::mutex> guard{table.lock};
+    if (auto it = table.ids.find(name); it != table.ids.end()) {
+        return table.entries[it->second];
+    }
+    const auto id = table.entries.size();
+    const auto & stored = table.entries.add(name);
+    table.ids.emplace(name, id);
+    table.addresses.emplace(&stored, id);
+    return stored;
+}
+
+FileId Files::id(const std::string & interned) {
+    // Nodes are created in runs from the same file, so remember the last one
+    // to avoid taking the lock for each of them. Names are never moved or
+    // removed, so this can never be stale.
+    thread_local const std::string * last = nullptr;
+    thread_local FileId last_id = 0;
+    if (&interned == last) {
+        return last_id;
+    }
+
+    auto & table = file_table();
+    std::lock_guard<std::mutex> guard{table.lock};
+    const auto it = table.addresses.find(&interned);
+    assert(it != table.addresses.end() && "Location filename was not returned by Files::intern");
+    if (it == table.addresses.end()) {
+        return table.ids.at(interned);
+    }
+    last = &interned;
+    last_id = it->second;
+    return last_id;
+}
+
+const std::string & Files::name(FileId id) { return file_table().entries[id]; }
+
 std::string Number::as_string() const { return std::to_string(value); };
 
 std::string Boolean::as_string() const { return value ? "true" : "false"; };
 
 std::string String::as_string() const {
     if (is_triple) {
-        return "'''" + value + "'''";
+        return "'''" + std::string{value} + "'''";
     }
     if (is_fstring) {
-        return "f'" + value + "'";
+        return "f'" + std::string{value} + "'";
     }
-    return "'" + value + "'";
+    return "'" + std::string{value} + "'";
 };
 
-std::string Identifier::as_string() const { return value; };
+std::string Identifier::as_string() const { return std::string{value}; };
 
 std::string Assignment::as_string() const {
     std::string o{};
@@ -5,15 +5,19 @@
 
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 
+#include "arena.hpp"
 #include "locations.hpp"
+#include "source.hpp"
 
 namespace Frontend::AST {
 
@@ -43,22 +47,58 @@ using ExpressionV =
 
 using ExpressionList = std::vector<ExpressionV>;
 
+/// A compact identifier for a parsed file
+using FileId = std::uint32_t;
+
+/**
+ * The names of all parsed files
+ *
+ * Each file name is stored once, and Locations refer to it by id. Entries
+ * are never removed, so references to names remain valid for the life of the
+ * program. This is safe to use from multiple threads.
+ */
+class Files {
+  public:
+    /**
+     * Add a file name, or find the existing entry for it
+     *
+     * @return The stored name, which is suitable for use as the filename of a
+     *         bison location
+     */
+    static const std::string & intern(const std::string & name);
+
+    /**
+     * Get the id of a name returned by intern()
+     *
+     * The name is found by its address, so this does not hash the string. The
+     * last name looked up by each thread is remembered, so usually this does
+     * not take a lock either.
+     */
+    static FileId id(const std::string & interned);
+
+    /// Get the name of a file, this does not take a lock
+    static const std::string & name(FileId);
+};
+
 class Location {
   public:
     Location(const location & l)
         : column_start{l.begin.column}, column_end{l.end.column}, line_start{l.begin.line},
-          line_end{l.end.line}, filename{*l.begin.filename} {};
-    virtual ~Location() = default;
+          line_end{l.end.line}, file{Files::id(*l.begin.filename)} {};
     Location(const Location &) = default;
+    ~Location() = default;
+
+    /// The name of the file this location is in
+    const std::string & filename() const { return Files::name(file); }
 
     const int column_start;
     const int column_end;
     const int line_start;
     const int line_end;
-    const std::string filename;
+    const FileId file;
 };
 
-class Number {
+class Number : public ArenaAllocated {
   public:
     Number(const int64_t & number, const location & l) : value{number}, loc{l} {};
     Number(Number && n) noexcept : value{n.value}, loc{n.loc} {};
@@ -71,7 +111,7 @@ class Number {
     Location loc;
 };
 
-class Boolean {
+class Boolean : public ArenaAllocated {
   public:
     Boolean(const bool & b, const location & l) : value{b}, loc{l} {};
     Boolean(Boolean && b) noexcept : value{b.value}, loc{b.loc} {};
@@ -84,38 +124,39 @@ class Boolean {
     Location loc;
 };
 
-class String {
+class String : public ArenaAllocated {
   public:
-    String(std::string str, const bool & t, const bool & f, const location & l)
-        : value{std::move(str)}, is_triple{t}, is_fstring{f}, loc{l} {};
+    String(std::string_view str, const bool & t, const bool & f, const location & l)
+        : value{str}, is_triple{t}, is_fstring{f}, loc{l} {};
     String(String && s) noexcept
-        : value{std::move(s.value)}, is_triple{s.is_triple}, is_fstring{s.is_fstring},
-          loc{s.loc} {};
+        : value{s.value}, is_triple{s.is_triple}, is_fstring{s.is_fstring}, loc{s.loc} {};
     String(const String &) = delete;
     ~String() = default;
 
     std::string as_string() const;
 
-    std::string value;
+    /// A view into the Source this was parsed from
+    std::string_view value;
     bool is_triple;
     bool is_fstring;
     Location loc;
 };
 
-class Identifier {
+class Identifier : public ArenaAllocated {
   public:
-    Identifier(std::string str, const location & l) : value{std::move(str)}, loc{l} {};
-    Identifier(Identifier && s) noexcept : value{std::move(s.value)}, loc{s.loc} {};
+    Identifier(std::string_view str, const location & l) : value{str}, loc{l} {};
+    Identifier(Identifier && s) noexcept : value{s.value}, loc{s.loc} {};
     Identifier(const Identifier &) = delete;
     ~Identifier() = default;
 
     std::string as_string() const;
 
-    std::string value;
+    /// A view into the Source this was parsed from
+    std::string_view value;
     Location loc;
 };
 
-class Subscript {
+class Subscript : public ArenaAllocated {
   public:
     Subscript(ExpressionV && l, ExpressionV && r, location & lo)
         : lhs{std::move(l)}, rhs{std::move(r)}, loc{lo} {};
@@ -136,7 +177,7 @@ enum class UnaryOp {
     NOT,
 };
 
-class UnaryExpression {
+class UnaryExpression : public ArenaAllocated {
   public:
     UnaryExpression(const UnaryOp & o, ExpressionV && r, location & l)
         : op{o}, rhs{std::move(r)}, loc{l} {};
@@ -157,7 +198,7 @@ enum class MulOp {
     MOD,
 };
 
-class MultiplicativeExpression {
+class MultiplicativeExpression : public ArenaAllocated {
   public:
     MultiplicativeExpression(ExpressionV && l, const MulOp & o, ExpressionV && r, location & lo)
         : lhs{std::move(l)}, op{o}, rhs{std::move(r)}, loc{lo} {};
@@ -179,7 +220,7 @@ enum class AddOp {
     SUB,
 };
 
-class AdditiveExpression {
+class AdditiveExpression : public ArenaAllocated {
   public:
     AdditiveExpression(ExpressionV && l, const AddOp & o, ExpressionV && r, location & lo)
         : lhs{std::move(l)}, op{o}, rhs{std::move(r)}, loc{lo} {};
@@ -210,7 +251,7 @@ enum class RelationalOp {
 };
 
 // TODO: move this into the parser cpp
-static AST::RelationalOp to_relop(const std::string & s) {
+static AST::RelationalOp to_relop(std::string_view s) {
     if (s == "<")
         return AST::RelationalOp::LT;
     if (s == "<=")
@@ -235,10 +276,12 @@ static AST::RelationalOp to_relop(const std::string & s) {
     assert(false);
 }
 
-class Relational {
+class Relational : public ArenaAllocated {
   public:
-    Relational(ExpressionV && l, const std::string & o, ExpressionV && r, location & lo)
+    Relational(ExpressionV && l, std::string_view o, ExpressionV && r, location & lo)
         : lhs{std::move(l)}, op{to_relop(o)}, rhs{std::move(r)}, loc{lo} {};
+    Relational(ExpressionV && l, const RelationalOp & o, ExpressionV && r, location & lo)
+        : lhs{std::move(l)}, op{o}, rhs{std::move(r)}, loc{lo} {};
     Relational(Relational && a) noexcept
         : lhs{std::move(a.lhs)}, op{a.op}, rhs{std::move(a.rhs)}, loc{a.loc} {};
     Relational(const Relational &) = delete;
@@ -256,7 +299,7 @@ class Relational {
 using KeywordPair = std::tuple<ExpressionV, ExpressionV>;
 using KeywordList = std::vector<KeywordPair>;
 
-class Arguments {
+class Arguments : public ArenaAllocated {
   public:
     Arguments(location & l) : loc{l} {};
     Arguments(ExpressionList && v, location & l) : positional{std::move(v)}, loc{l} {};
@@ -275,7 +318,7 @@ class Arguments {
     Location loc;
 };
 
-class FunctionCall {
+class FunctionCall : public ArenaAllocated {
   public:
     FunctionCall(ExpressionV && i, std::unique_ptr<Arguments> && a, location & l)
         : held{std::move(i)}, args{std::move(a)}, loc{l} {};
@@ -291,7 +334,7 @@ class FunctionCall {
     Location loc;
 };
 
-class GetAttribute {
+class GetAttribute : public ArenaAllocated {
   public:
     GetAttribute(ExpressionV && o, ExpressionV && i, location & l)
         : holder{std::move(o)}, held{std::move(i)}, loc{l} {};
@@ -309,7 +352,7 @@ class GetAttribute {
     Location loc;
 };
 
-class Array {
+class Array : public ArenaAllocated {
   public:
     Array(location & l) : loc{l} {};
     Array(ExpressionList && e, location & l) : elements{std::move(e)}, loc{l} {};
@@ -323,7 +366,7 @@ class Array {
     Location loc;
 };
 
-class Dict {
+class Dict : public ArenaAllocated {
   public:
     Dict(location & l) : loc{l} {};
     Dict(KeywordList && l, location & lo);
@@ -337,7 +380,7 @@ class Dict {
     Location loc;
 };
 
-class Ternary {
+class Ternary : public ArenaAllocated {
   public:
     Ternary(ExpressionV && c, ExpressionV && l, ExpressionV && r, location & lo)
         : condition{std::move(c)}, lhs{std::move(l)}, rhs{std::move(r)}, loc{lo} {};
@@ -355,7 +398,7 @@ class Ternary {
     Location loc;
 };
 
-class Statement {
+class Statement : public ArenaAllocated {
   public:
     Statement(ExpressionV && e) : expr{std::move(e)} {};
     Statement(Statement && a) noexcept : expr{std::move(a.expr)} {};
@@ -376,7 +419,7 @@ enum class AssignOp {
     MOD_EQUAL,
 };
 
-class Assignment {
+class Assignment : public ArenaAllocated {
   public:
     Assignment(ExpressionV && l, AssignOp & o, ExpressionV && r)
         : lhs{std::move(l)}, op{o}, rhs{std::move(r)} {};
@@ -392,7 +435,7 @@ class Assignment {
     ExpressionV rhs;
 };
 
-class Break {
+class Break : public ArenaAllocated {
   public:
     Break() = default;
     ~Break() = default;
@@ -401,7 +444,7 @@ class Break {
     std::string as_string() const;
 };
 
-class Continue {
+class Continue : public ArenaAllocated {
   public:
     Continue() = default;
     ~Continue() = default;
@@ -421,18 +464,50 @@ class CodeBlock {
   public:
     CodeBlock() = default;
     CodeBlock(StatementV && stmt) { statements.emplace_back(std::move(stmt)); };
-    CodeBlock(CodeBlock && b) noexcept : statements{std::move(b.statements)} {};
+    CodeBlock(CodeBlock && b) noexcept
+        : arenas{std::move(b.arenas)}, statements{std::move(b.statements)},
+          sources{std::move(b.sources)} {};
     CodeBlock(const CodeBlock &) = delete;
     ~CodeBlock() = default;
 
-    CodeBlock & operator=(CodeBlock &&) = default;
+    CodeBlock & operator=(CodeBlock && b) noexcept {
+        // The old statements must be destroyed before the arenas they were
+        // allocated from.
+        statements = std::move(b.statements);
+        arenas = std::move(b.arenas);
+        sources = std::move(b.sources);
+        return *this;
+    };
 
     std::string as_string() const;
 
+    /**
+     * The arenas that the statements were allocated from
+     *
+     * This is declared before the statements so that it is destroyed after
+     * them.
+     */
+    std::vector<std::unique_ptr<Arena>> arenas;
+
     // XXX: this should probably be a statement list
     std::vector<StatementV> statements;
+
+    /**
+     * The files that the statements were parsed from
+     *
+     * Strings and Identifiers are views into these, so they must be kept
+     * alive as long as the statements are.
+     */
+    std::vector<std::shared_ptr<Source>> sources;
 };
 
+/**
+ * Consumes top level statements as they are parsed
+ *
+ * @see Driver::parse
+ */
+using StatementSink = std::function<void(StatementV)>;
+
 class IfBlock {
   public:
     IfBlock() = default;
@@ -479,7 +554,7 @@ class ElseBlock {
     std::unique_ptr<CodeBlock> block;
 };
 
-class IfStatement {
+class IfStatement : public ArenaAllocated {
   public:
     IfStatement(IfBlock && ib) : ifblock{std::move(ib)} {};
     IfStatement(IfBlock && ib, ElseBlock && eb) : ifblock{std::move(ib)}, eblock{std::move(eb)} {};
@@ -500,7 +575,7 @@ class IfStatement {
     ElseBlock eblock;
 };
 
-class ForeachStatement {
+class ForeachStatement : public ArenaAllocated {
   public:
     ForeachStatement(Identifier && i, ExpressionV && e, std::unique_ptr<CodeBlock> && b)
         : id{std::move(i)}, id2{std::nullopt}, expr{std::move(e)}, block{std::move(b)} {};
@@ -3,16 +3,44 @@
 
 #pragma once
 
+#include <filesystem>
 #include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "cache.hpp"
 #include "node.hpp"
 
 namespace Frontend::AST {
 
+/// Files that have already been parsed, keyed by their path
+using ParsedFiles = std::unordered_map<std::string, std::unique_ptr<CodeBlock>>;
+
+/**
+ * Get the file referenced by a `subdir()` call
+ *
+ * @return the path to the meson.build file if this is a subdir() call,
+ * otherwise nullopt
+ */
+std::optional<std::filesystem::path> subdir_file(const Statement &);
+
+/**
+ * Find all of the files referenced by `subdir()` calls in a block
+ *
+ * This only looks at the block itself (and any if/elif/else blocks in it), it
+ * does not look into the referenced files. Files are appended in statement
+ * order.
+ */
+void find_subdir_files(const CodeBlock &, std::vector<std::filesystem::path> &);
+
 /**
  * Convert all `subdir()` calls into AST and insert it into the tree.
  */
 struct SubdirVisitor {
+    SubdirVisitor() = default;
+    SubdirVisitor(ParsedFiles * p, const Cache * c) : parsed{p}, cache{c} {};
+
     std::optional<std::unique_ptr<CodeBlock>> operator()(const std::unique_ptr<Statement> &) const;
     std::optional<std::unique_ptr<CodeBlock>>
     operator()(const std::unique_ptr<IfStatement> &) const;
@@ -30,6 +58,24 @@ struct SubdirVisitor {
     std::optional<std::unique_ptr<CodeBlock>> operator()(const std::unique_ptr<Continue> &) const {
         return std::nullopt;
     };
+
+    /**
+     * Files which have already been parsed, but have not had their own
+     * `subdir()` calls replaced.
+     *
+     * If this is null, or a file is not in it, the file is parsed when the
+     * `subdir()` call is encountered.
+     */
+    ParsedFiles * parsed = nullptr;
+
+    /// The cache to use for files that are parsed
+    const Cache * cache = nullptr;
 };
 
+/**
+ * Replace all `subdir()` calls in a block with the contents of the file
+ * referenced
+ */
+void replace_subdirs(CodeBlock &, const SubdirVisitor &);
+
 } // namespace Frontend::AST
@@ -11,6 +11,7 @@
 
 %code requires {
     #include <memory>
+    #include <string_view>
     #include "node.hpp"
 
     namespace Frontend {
@@ -21,10 +22,12 @@
 
 %parse-param { Scanner & scanner }
 %parse-param { std::unique_ptr<AST::CodeBlock> & block }
+%parse-param { const AST::StatementSink * sink }
 
 %locations
 %initial-action {
     @$.begin.filename = @$.end.filename = &scanner.filename;
+    block = std::make_unique<AST::CodeBlock>();
 }
 
 %code {
@@ -37,12 +40,30 @@
 
     #undef yylex
     #define yylex scanner.yylex
+
+    namespace {
+
+    /**
+     * Pass a complete top level statement to the sink, or add it to the block
+     * if there isn't one
+     */
+    void add_statement(std::unique_ptr<Frontend::AST::CodeBlock> & block,
+                       const Frontend::AST::StatementSink * sink,
+                       Frontend::AST::StatementV && stmt) {
+        if (sink != nullptr) {
+            (*sink)(std::move(stmt));
+        } else {
+            block->statements.emplace_back(std::move(stmt));
+        }
+    }
+
+    }
 }
 
 %define api.value.type variant
 %define parse.assert
 
-%token <std::string>    IDENTIFIER TSTRING STRING FSTRING RELATIONAL
+%token <std::string_view> IDENTIFIER TSTRING STRING FSTRING RELATIONAL
 %token <int64_t>        NUMBER
 %token <bool>           BOOL
 %token <AST::AssignOp>  ASSIGN
@@ -76,7 +97,7 @@
 %nterm <AST::KeywordList>                           keyword_arguments
 %nterm <std::unique_ptr<AST::Arguments>>            arguments
 %nterm <AST::ExpressionList>                        positional_arguments
-%nterm <std::unique_ptr<AST::CodeBlock>>            program statements
+%nterm <std::unique_ptr<AST::CodeBlock>>            statements
 %nterm <AST::ElseBlock>                             else_clause
 %nterm <std::vector<AST::ElifBlock>>                elif_clause in_elif_clause
 %nterm <AST::IfBlock>                               if_clause
@@ -94,11 +115,15 @@
 
 %%
 
-program : %empty                                    { block = std::make_unique<AST::CodeBlock>(); }
-        | statements                                { block = std::move($1); }
-        | statements "\n"                           { block = std::move($1); }
+program : %empty
+        | top_statements
+        | top_statements "\n"
         ;
 
+top_statements : statement                          { add_statement(block, sink, std::move($1)); }
+               | top_statements "\n" statement      { add_statement(block, sink, std::move($3)); }
+               ;
+
 statements : statement                              { $$ = std::make_unique<AST::CodeBlock>(std::move($1)); }
            | statements "\n" statement              { $1->statements.push_back(std::move($3)); $$ = std::move($1); }
            ;
@@ -1,11 +1,16 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright © 2021-2024 Intel Corporation
 
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <memory>
 #include <sstream>
 #include <variant>
 
+#include <unistd.h>
+
+#include "cache.hpp"
 #include "driver.hpp"
 #include "node.hpp"
 
@@ -25,6 +30,49 @@ TEST(parser, string) {
     ASSERT_EQ(stmt->as_string(), "'foo'");
 }
 
+TEST(parser, string_is_view_of_source) {
+    auto block = parse("x = 'foo'\ny = 'b\\'ar'");
+    ASSERT_EQ(block->statements.size(), 2);
+    ASSERT_EQ(block->sources.size(), 1);
+    const auto text = block->sources[0]->contents();
+
+    // Without escapes the value is a view into the file
+    const auto & x = std::get<std::unique_ptr<Frontend::AST::Assignment>>(block->statements[0]);
+    const auto & foo = std::get<std::unique_ptr<Frontend::AST::String>>(x->rhs);
+    ASSERT_EQ(foo->value, "foo");
+    ASSERT_GE(foo->value.data(), text.data());
+    ASSERT_LE(foo->value.data() + foo->value.size(), text.data() + text.size());
+
+    // With them it can't be
+    const auto & y = std::get<std::unique_ptr<Frontend::AST::Assignment>>(block->statements[1]);
+    const auto & bar = std::get<std::unique_ptr<Frontend::AST::String>>(y->rhs);
+    ASSERT_EQ(bar->value, "b'ar");
+}
+
+TEST(parser, arena_allocated) {
+    auto block = parse("x = ['a', 'b', 'c']");
+    ASSERT_EQ(block->statements.size(), 1);
+    ASSERT_EQ(block->arenas.size(), 1);
+
+    // The nodes of the file came from its arena
+    const auto & arena = *block->arenas[0];
+    ASSERT_GE(arena.allocations(), 6);
+    const auto & assign =
+        std::get<std::unique_ptr<Frontend::AST::Assignment>>(block->statements[0]);
+    ASSERT_TRUE(arena.owns(assign.get()));
+    const auto & array = std::get<std::unique_ptr<Frontend::AST::Array>>(assign->rhs);
+    ASSERT_EQ(array->elements.size(), 3);
+    for (const auto & e : array->elements) {
+        ASSERT_TRUE(arena.owns(std::get<std::unique_ptr<Frontend::AST::String>>(e).get()));
+    }
+
+    // Nodes created outside of the parser come from the heap
+    ASSERT_EQ(Frontend::AST::Arena::current(), nullptr);
+    auto heap = std::make_unique<Frontend::AST::Break>();
+    ASSERT_NE(heap, nullptr);
+    ASSERT_FALSE(arena.owns(heap.get()));
+}
+
 TEST(parser, escape_in_string) {
     auto block = parse("'can\\'t'");
     ASSERT_EQ(block->statements.size(), 1);
@@ -114,7 +162,40 @@ TEST(parser, locations) {
     ASSERT_EQ(expr->loc.column_end, 3);
     ASSERT_EQ(expr->loc.line_end, 1);
     std::string expected{"test file name"};
-    ASSERT_EQ(expected, expr->loc.filename);
+    ASSERT_EQ(expected, expr->loc.filename());
+}
+
+TEST(parser, interned_filenames) {
+    auto block = parse("a\nb");
+    auto other = parse("c");
+    const auto & a = std::get<std::unique_ptr<Frontend::AST::Identifier>>(
+        std::get<0>(block->statements[0])->expr);
+    const auto & b = std::get<std::unique_ptr<Frontend::AST::Identifier>>(
+        std::get<0>(block->statements[1])->expr);
+    const auto & c = std::get<std::unique_ptr<Frontend::AST::Identifier>>(
+        std::get<0>(other->statements[0])->expr);
+    ASSERT_EQ(a->loc.file, b->loc.file);
+    ASSERT_EQ(a->loc.file, c->loc.file);
+    ASSERT_EQ(&a->loc.filename(), &c->loc.filename());
+}
+
+TEST(parser, file_ids) {
+    using Frontend::AST::Files;
+    const auto & first = Files::intern("first file name");
+    const auto & second = Files::intern("second file name");
+    const auto id = Files::id(first);
+    ASSERT_NE(id, Files::id(second));
+    ASSERT_EQ(id, Files::id(first));
+    ASSERT_EQ(Files::name(id), "first file name");
+    ASSERT_EQ(&Files::name(Files::id(second)), &second);
+
+    // Names stay in place as more are added
+    for (int i = 0; i < 1000; ++i) {
+        const auto & name = Files::intern("file name " + std::to_string(i));
+        ASSERT_EQ(&Files::name(Files::id(name)), &name);
+    }
+    ASSERT_EQ(&Files::name(id), &first);
+    ASSERT_EQ(&Files::intern("file name 10"), &Files::intern("file name 10"));
 }
 
 TEST(parser, octal_number) {
@@ -615,3 +696,134 @@ TEST(parser, method_in_function) {
     const auto & held = std::get<std::unique_ptr<Frontend::AST::FunctionCall>>(getattr->held);
     ASSERT_EQ(held->as_string(), "method()");
 }
+
+TEST(parser, source_outlives_file_changes) {
+    namespace fs = std::filesystem;
+    const fs::path path =
+        fs::temp_directory_path() / ("mesonpp-parser-source-" + std::to_string(getpid()));
+    std::ofstream{path} << "x = 'foo'\n";
+
+    const Frontend::Source src{path};
+
+    // The text is not affected by the file being truncated or replaced
+    fs::resize_file(path, 0);
+    ASSERT_EQ(src.contents(), "x = 'foo'\n");
+    fs::remove(path);
+    ASSERT_EQ(src.contents(), "x = 'foo'\n");
+}
+
+TEST(parser, parallel_subdir) {
+    namespace fs = std::filesystem;
+    const fs::path root =
+        fs::temp_directory_path() / ("mesonpp-parser-parallel-subdir-" + std::to_string(getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root / "a" / "c");
+    fs::create_directories(root / "b");
+
+    std::ofstream{root / "meson.build"} << "project('foo')\nsubdir('a')\nif true\n"
+                                           "  subdir('b')\nelse\n  subdir('a/c')\nendif\n"
+                                           "x = 1\n";
+    std::ofstream{root / "a" / "meson.build"} << "a = 1\nsubdir('c')\n";
+    std::ofstream{root / "a" / "c" / "meson.build"} << "c = 3\n";
+    std::ofstream{root / "b" / "meson.build"} << "b = 2\n";
+
+    auto serial = Frontend::Driver{}.parse(root / "meson.build");
+    auto parallel = Frontend::Driver{4}.parse(root / "meson.build");
+    fs::remove_all(root);
+
+    ASSERT_EQ(serial->statements.size(), 5);
+    ASSERT_EQ(parallel->statements.size(), serial->statements.size());
+    ASSERT_EQ(parallel->as_string(), serial->as_string());
+}
+
+TEST(parser, streaming) {
+    namespace fs = std::filesystem;
+    const fs::path root =
+        fs::temp_directory_path() / ("mesonpp-parser-streaming-" + std::to_string(getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root / "a" / "c");
+    fs::create_directories(root / "b");
+
+    std::ofstream{root / "meson.build"} << "project('foo')\nsubdir('a')\nif true\n"
+                                           "  subdir('b')\nelse\n  subdir('a/c')\nendif\n"
+                                           "x = 1\n";
+    std::ofstream{root / "a" / "meson.build"} << "a = 1\nsubdir('c')\n";
+    std::ofstream{root / "a" / "c" / "meson.build"} << "c = 3\n";
+    std::ofstream{root / "b" / "meson.build"} << "b = 2\n";
+
+    auto parsed = Frontend::Driver{}.parse(root / "meson.build");
+
+    std::vector<std::string> streamed{};
+    Frontend::Driver{}.parse(root / "meson.build", [&](Frontend::AST::StatementV stmt) {
+        streamed.emplace_back(Frontend::AST::CodeBlock{std::move(stmt)}.as_string());
+    });
+    fs::remove_all(root);
+
+    ASSERT_EQ(streamed.size(), parsed->statements.size());
+    for (std::size_t i = 0; i < streamed.size(); ++i) {
+        ASSERT_EQ(streamed[i],
+                  Frontend::AST::CodeBlock{std::move(parsed->statements[i])}.as_string());
+    }
+}
+
+TEST(parser, cache) {
+    namespace fs = std::filesystem;
+    const fs::path root =
+        fs::temp_directory_path() / ("mesonpp-parser-cache-" + std::to_string(getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root / "sub");
+
+    std::ofstream{root / "meson.build"}
+        << "project('foo')\nx = {'a' : [1, -2, 0x10]}\nif x.get('a') != 'can\\'t'\n"
+           "  subdir('sub')\nelif not true\n  y = x['a'] % 2\nelse\n  break\nendif\n"
+           "foreach k, v : x\n  z = k in v ? f'@k@' : '''tri'''\nendforeach\n";
+    std::ofstream{root / "sub" / "meson.build"} << "w = 1 + 2 * 3 - 4 / 5\n";
+
+    const Frontend::Cache cache{root / "cache", "test version"};
+    Frontend::Driver drv{};
+    drv.cache = &cache;
+    auto parsed = drv.parse(root / "meson.build");
+
+    // An entry should have been written for both files
+    Frontend::Source src{root / "meson.build"};
+    auto cached = cache.load(src, root / "meson.build");
+    ASSERT_NE(cached, nullptr);
+    Frontend::Source sub_src{root / "sub" / "meson.build"};
+    ASSERT_NE(cache.load(sub_src, root / "sub" / "meson.build"), nullptr);
+
+    // Loading through the cache gives the same tree
+    auto loaded = drv.parse(root / "meson.build");
+    ASSERT_EQ(loaded->as_string(), parsed->as_string());
+
+    // But not if a different version wrote the cache
+    const Frontend::Cache other{root / "cache", "other version"};
+    ASSERT_EQ(other.load(src, root / "meson.build"), nullptr);
+
+    // Or if the entry is for another file of the same size whose contents
+    // hash the same, which is simulated by renaming one entry to the other
+    std::ofstream{root / "other.build"} << "w = 1 + 2 * 3 - 4 / 6\n";
+    Frontend::Source other_src{root / "other.build"};
+    const Frontend::Cache first{root / "first", "test version"};
+    const Frontend::Cache second{root / "second", "test version"};
+    first.store(sub_src, *cache.load(sub_src, root / "sub" / "meson.build"));
+    second.store(other_src, *cache.load(sub_src, root / "sub" / "meson.build"));
+    const auto entry = [](const fs::path & dir) { return fs::directory_iterator{dir}->path(); };
+    fs::rename(entry(root / "first"), entry(root / "second"));
+    ASSERT_EQ(second.load(other_src, root / "other.build"), nullptr);
+
+    // Entries that are not used are pruned, the ones that are are kept
+    std::ofstream{root / "cache" / "0123.ast"} << "stale";
+    const Frontend::Cache next{root / "cache", "test version"};
+    drv.cache = &next;
+    drv.parse(root / "meson.build");
+    next.prune();
+    ASSERT_FALSE(fs::exists(root / "cache" / "0123.ast"));
+    ASSERT_NE(next.load(src, root / "meson.build"), nullptr);
+    ASSERT_NE(next.load(sub_src, root / "sub" / "meson.build"), nullptr);
+
+    // Pruning a cache that was never written to is not an error
+    const Frontend::Cache missing{root / "missing", "test version"};
+    ASSERT_NO_THROW(missing.prune());
+
+    fs::remove_all(root);
+}
@@ -4,19 +4,23 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 #ifndef yyFlexLexerOnce
 #include <FlexLexer.h>
 #endif
 
 #include "parser.yy.hpp"
+#include "source.hpp"
 
 namespace Frontend {
 
 class Scanner : public yyFlexLexer {
   public:
-    Scanner(std::istream * in, std::string s) : yyFlexLexer{in}, filename{std::move(s)} {};
+    Scanner(Source & src, const std::string & s)
+        : yyFlexLexer{nullptr}, filename{AST::Files::intern(s)}, source{src} {};
     ~Scanner() override = default;
 
     using FlexLexer::yylex;
@@ -24,9 +28,45 @@ class Scanner : public yyFlexLexer {
     virtual int yylex(Frontend::Parser::semantic_type * const lval,
                       Frontend::Parser::location_type * loc);
 
-    std::string filename;
+    /// The interned name of the file being scanned, see AST::Files
+    const std::string & filename;
+
+  protected:
+    /**
+     * Feed flex directly from the Source, instead of through an istream
+     */
+    int LexerInput(char * buf, int max_size) override;
 
   private:
+    /**
+     * Get the text of the current token as a view into the Source
+     */
+    std::string_view token() const { return source.contents().substr(offset - yyleng, yyleng); }
+
+    /**
+     * Start scanning a string literal, at the opening quote
+     */
+    void begin_string();
+
+    /**
+     * Append the current token to the string literal verbatim
+     */
+    void append_string();
+
+    /**
+     * Append the value of an escape sequence to the string literal
+     */
+    void append_escape(std::string_view);
+
+    /**
+     * Finish the string literal, at the closing quote
+     *
+     * @return the complete literal, including the quotes. If the literal had
+     *         no escapes this is a view into the Source, otherwise it is
+     *         interned in the Source.
+     */
+    std::string_view end_string();
+
     /**
      * Increase the brace level by one
      */
@@ -45,6 +85,15 @@ class Scanner : public yyFlexLexer {
      */
     bool brace() { return inside_brace > 0; }
 
+    /// The text being scanned
+    Source & source;
+
+    /// How much of the Source has been passed to flex
+    std::size_t read_pos = 0;
+
+    /// How much of the Source has been consumed by matched tokens
+    std::size_t offset = 0;
+
     /**
      * Track if we're inside a brace, and how deep
      *
@@ -63,6 +112,23 @@ class Scanner : public yyFlexLexer {
      * `cc.get_supported_arguments`, and one for the array literal
      */
     unsigned inside_brace = 0;
+
+    /**
+     * Buffer for the string literal currently being scanned
+     *
+     * This is only used once an escape sequence is found, until then the
+     * literal is exactly the text of the Source.
+     *
+     * This is per-Scanner rather than global so that multiple files can be
+     * scanned at the same time from different threads.
+     */
+    std::string strbuffer{};
+
+    /// Offset of the opening quote of the string literal being scanned
+    std::size_t str_start = 0;
+
+    /// Whether the string literal being scanned has an escape sequence
+    bool str_escaped = false;
 };
 
 }; // namespace Frontend
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2024 Intel Corporation
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "exceptions.hpp"
+#include "source.hpp"
+
+namespace Frontend {
+
+Source::Source(const std::string & filename) {
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw Util::Exceptions::MesonException{"Cannot open file " + filename + ": " +
+                                               std::strerror(errno)};
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw Util::Exceptions::MesonException{"Cannot stat file " + filename + ": " +
+                                               std::strerror(errno)};
+    }
+
+    // The file is read rather than mapped. A mapping raises SIGBUS when the
+    // file is truncated while it is in use, and the AST holds views into the
+    // text long after lexing. Reading it once into a buffer sized from the
+    // stat still avoids copying it through a stream and into each node.
+    buffer.resize(static_cast<std::size_t>(st.st_size));
+    std::size_t done = 0;
+    while (true) {
+        if (done == buffer.size()) {
+            // The file may have grown since the stat
+            buffer.resize(buffer.size() + 4096);
+        }
+        const ssize_t got = read(fd, buffer.data() + done, buffer.size() - done);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const int err = errno;
+            close(fd);
+            throw Util::Exceptions::MesonException{"Cannot read file " + filename + ": " +
+                                                   std::strerror(err)};
+        }
+        if (got == 0) {
+            break;
+        }
+        done += static_cast<std::size_t>(got);
+    }
+    buffer.resize(done);
+    close(fd);
+
+    data = buffer.data();
+    size = buffer.size();
+}
+
+Source::Source(std::istream & in)
+    : buffer{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}} {
+    data = buffer.data();
+    size = buffer.size();
+}
+
+std::string_view Source::intern(const std::string & str) {
+    // Elements of an unordered_set are never moved, so the view remains valid
+    // even if the set rehashes.
+    return *interned.emplace(str).first;
+}
+
+} // namespace Frontend
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2024 Intel Corporation
+
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace Frontend {
+
+/**
+ * The text of a single input file
+ *
+ * The text is read into memory once, and the String and Identifier nodes of
+ * the AST hold views into that memory rather than copies. Because of that the
+ * Source must outlive any AST created from it.
+ */
+class Source {
+  public:
+    /**
+     * Read a file into memory
+     *
+     * @throws Util::Exceptions::MesonException if the file cannot be read
+     */
+    explicit Source(const std::string & filename);
+
+    /**
+     * Read an entire stream into memory
+     */
+    explicit Source(std::istream &);
+
+    Source(const Source &) = delete;
+    Source & operator=(const Source &) = delete;
+
+    /**
+     * The complete text of the file
+     */
+    std::string_view contents() const { return {data, size}; }
+
+    /**
+     * Store text that does not appear verbatim in the file
+     *
+     * This is used for string literals that contain escapes, identical
+     * strings are only stored once.
+     *
+     * @return A view that is valid for the lifetime of this Source
+     */
+    std::string_view intern(const std::string &);
+
+  private:
+    const char * data = nullptr;
+    std::size_t size = 0;
+
+    /// Storage for the text
+    std::string buffer{};
+
+    /// Strings with escapes, which cannot point into the file
+    std::unordered_set<std::string> interned{};
+};
+
+} // namespace Frontend
@@ -1,12 +1,291 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright © 2021-2024 Intel Corporation
 
+/**
+ * A standalone parser, and a benchmark for the frontend
+ *
+ * With a single file argument the file is parsed and the AST is printed.
+ *
+ * With `--benchmark <shape> [size] [iterations]` a synthetic project of the
+ * given shape is generated in a temporary directory, and the time taken by
+ * Driver::parse to parse it is measured, along with the throughput in tokens
+ * and nodes, the peak RSS, and the number of allocations made while parsing.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "arena.hpp"
 #include "driver.hpp"
+#include "scanner.hpp"
+#include "source.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+std::atomic<std::uint64_t> allocated_bytes{0};
+
+} // namespace
+
+void * operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void * ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+const std::string usage = R"EOF(Usage:
+    standalone_parser <file>
+    standalone_parser --benchmark <shape> [size] [iterations]
+
+Shapes:
+    files   One files() call with <size> arguments
+    if      An if statement with <size> elif branches
+    subdir  <size> levels of nested subdir() calls
+    dict    A dict literal with <size> entries
+)EOF";
+
+/**
+ * A generated project
+ *
+ * Writes the files of the project into a directory, the root file is always
+ * `meson.build` in that directory.
+ *
+ * @return all of the files written
+ */
+using Generator = std::function<std::vector<fs::path>(const fs::path &, unsigned)>;
+
+std::vector<fs::path> gen_files(const fs::path & root, unsigned size) {
+    std::ofstream out{root / "meson.build"};
+    out << "project('bench', 'c')\n\n";
+    out << "srcs = files(\n";
+    for (unsigned i = 0; i < size; ++i) {
+        out << "  'src/file" << i << ".c',\n";
+    }
+    out << ")\n\n";
+    out << "executable('bench', srcs, c_args : ['-DBENCH=1'], install : true)\n";
+    return {root / "meson.build"};
+}
+
+std::vector<fs::path> gen_if(const fs::path & root, unsigned size) {
+    std::ofstream out{root / "meson.build"};
+    out << "project('bench', 'c')\n\n";
+    out << "x = " << size / 2 << "\n";
+    out << "if x == 0\n  y = 'branch0'\n";
+    for (unsigned i = 1; i < size; ++i) {
+        out << "elif x == " << i << " and not (x > " << i * 2 << ")\n";
+        out << "  y = 'branch" << i << "'\n";
+        out << "  z = [y, x + " << i << "]\n";
+    }
+    out << "else\n  y = 'none'\nendif\n";
+    return {root / "meson.build"};
+}
+
+std::vector<fs::path> gen_subdir(const fs::path & root, unsigned size) {
+    std::vector<fs::path> written{};
+    fs::path dir = root;
+    for (unsigned i = 0; i <= size; ++i) {
+        const fs::path file = dir / "meson.build";
+        std::ofstream out{file};
+        if (i == 0) {
+            out << "project('bench', 'c')\n\n";
+        }
+        out << "srcs_" << i << " = files('a.c', 'b.c', 'c.c')\n";
+        out << "lib_" << i << " = static_library('lib" << i << "', srcs_" << i << ")\n";
+        if (i < size) {
+            out << "subdir('sub')\n";
+        }
+        written.emplace_back(file);
+        dir /= "sub";
+        fs::create_directory(dir);
+    }
+    return written;
+}
+
+std::vector<fs::path> gen_dict(const fs::path & root, unsigned size) {
+    std::ofstream out{root / "meson.build"};
+    out << "project('bench', 'c')\n\n";
+    out << "d = {\n";
+    for (unsigned i = 0; i < size; ++i) {
+        out << "  'key" << i << "' : ['value" << i << "', " << i << "],\n";
+    }
+    out << "}\n";
+    return {root / "meson.build"};
+}
+
+struct Shape {
+    Generator generate;
+    unsigned size;
+};
+
+const std::map<std::string, Shape> shapes{
+    {"files", {gen_files, 20000}},
+    {"if", {gen_if, 2000}},
+    {"subdir", {gen_subdir, 200}},
+    {"dict", {gen_dict, 10000}},
+};
+
+/// Count the tokens in a file, by running the scanner over it
+std::uint64_t count_tokens(const fs::path & file) {
+    using token = Frontend::Parser::token;
+
+    Frontend::Source src{file.string()};
+    Frontend::Scanner scanner{src, file.string()};
+    Frontend::Parser::semantic_type value{};
+    Frontend::Parser::location_type loc{};
+
+    std::uint64_t count = 0;
+    while (true) {
+        const int tok = scanner.yylex(&value, &loc);
+        if (tok == token::END) {
+            break;
+        }
+        ++count;
+
+        // The scanner builds the value of the token, which must be destroyed
+        // before the next token can be built.
+        switch (tok) {
+            case token::IDENTIFIER:
+            case token::TSTRING:
+            case token::STRING:
+            case token::FSTRING:
+            case token::RELATIONAL:
+                value.destroy<std::string_view>();
+                break;
+            case token::NUMBER:
+                value.destroy<int64_t>();
+                break;
+            case token::BOOL:
+                value.destroy<bool>();
+                break;
+            case token::ASSIGN:
+                value.destroy<Frontend::AST::AssignOp>();
+                break;
+            default:
+                break;
+        }
+    }
+    return count;
+}
+
+/// Get the peak resident set size of this process, in KiB
+long peak_rss() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int benchmark(const std::string & name, unsigned size, unsigned iterations) {
+    const auto found = shapes.find(name);
+    if (found == shapes.end()) {
+        std::cerr << "Unknown shape: " << name << "\n\n" << usage;
+        return 1;
+    }
+    const Shape & shape = found->second;
+    if (size == 0) {
+        size = shape.size;
+    }
+
+    const fs::path root =
+        fs::temp_directory_path() / ("mesonpp-parse-bench-" + std::to_string(getpid()));
+    fs::create_directories(root);
+
+    const std::vector<fs::path> files = shape.generate(root, size);
+    std::uint64_t tokens = 0;
+    for (const auto & f : files) {
+        tokens += count_tokens(f);
+    }
+
+    std::vector<double> times{};
+    std::uint64_t nodes = 0;
+    std::uint64_t allocs = 0;
+    std::uint64_t bytes = 0;
+    for (unsigned i = 0; i < iterations; ++i) {
+        Frontend::Driver drv{};
+
+        const std::uint64_t allocs_before = allocations.load();
+        const std::uint64_t bytes_before = allocated_bytes.load();
+        const auto start = std::chrono::steady_clock::now();
+
+        auto block = drv.parse((root / "meson.build").string());
+
+        const auto end = std::chrono::steady_clock::now();
+        allocs = allocations.load() - allocs_before;
+        bytes = allocated_bytes.load() - bytes_before;
+
+        times.emplace_back(std::chrono::duration<double>(end - start).count());
+
+        nodes = 0;
+        for (const auto & a : block->arenas) {
+            nodes += a->allocations();
+        }
+    }
+
+    fs::remove_all(root);
+
+    // The median is much less sensitive to noise than the mean
+    std::sort(times.begin(), times.end());
+    const double median = times[times.size() / 2];
+
+    std::cout << "shape:       " << name << " (size " << size << ", " << files.size()
+              << " files)\n"
+              << "iterations:  " << iterations << "\n"
+              << "time:        " << median * 1000 << " ms (median), " << times.front() * 1000
+              << " ms (min)\n"
+              << "tokens:      " << tokens << " (" << tokens / median << " tokens/sec)\n"
+              << "nodes:       " << nodes << " (" << nodes / median << " nodes/sec)\n"
+              << "allocations: " << allocs << " (" << bytes << " bytes) per parse\n"
+              << "peak RSS:    " << peak_rss() << " KiB\n";
+
+    return 0;
+}
+
+} // namespace
 
 int main(int argc, char ** argv) {
+    if (argc < 2) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    const std::string arg{argv[1]};
+    if (arg == "--benchmark") {
+        if (argc < 3) {
+            std::cerr << usage;
+            return 1;
+        }
+        const unsigned size = argc > 3 ? std::stoul(argv[3]) : 0;
+        const unsigned iterations = argc > 4 ? std::max(std::stoul(argv[4]), 1UL) : 10;
+        return benchmark(argv[2], size, iterations);
+    }
+
     Frontend::Driver drv{};
 
-    auto block = drv.parse(argv[1]);
+    auto block = drv.parse(arg);
 
     std::cout << block->as_string() << std::endl;
 
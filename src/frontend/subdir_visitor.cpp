@@ -9,40 +9,8 @@
 
 namespace Frontend::AST {
 
-namespace {
-
-/**
- * Walk a code block and rewrite any subdir() calls with the code in file
- * referenced
- */
-void subdir_replacer(std::unique_ptr<CodeBlock> & block) {
-    SubdirVisitor sv{};
-    std::vector<StatementV> new_stmts{};
-
-    // TODO: this code is basically copied out of the driver, how can we share it?
-    for (auto && stmt : block->statements) {
-        auto res = std::visit(sv, stmt);
-
-        // If we have a value that means that a `subdir()` call was
-        // encounted, we then wnat to add the staements from that call into
-        // our new statements instead of the current `subdir()` call.
-        // Otherwise just move the statement.
-        if (res.has_value()) {
-            auto & v = res.value();
-            std::move(v->statements.begin(), v->statements.end(), std::back_inserter(new_stmts));
-        } else {
-            new_stmts.emplace_back(std::move(stmt));
-        }
-    }
-
-    std::swap(block->statements, new_stmts);
-}
-
-} // namespace
-
-std::optional<std::unique_ptr<CodeBlock>>
-SubdirVisitor::operator()(const std::unique_ptr<Statement> & stmt) const {
-    const auto func_ptr = std::get_if<std::unique_ptr<FunctionCall>>(&stmt->expr);
+std::optional<std::filesystem::path> subdir_file(const Statement & stmt) {
+    const auto func_ptr = std::get_if<std::unique_ptr<FunctionCall>>(&stmt.expr);
     if (func_ptr == nullptr) {
         return std::nullopt;
     }
@@ -82,7 +50,7 @@ SubdirVisitor::operator()(const std::unique_ptr<Statement> & stmt) const {
     auto const & dir = *dir_ptr;
 
     // This assumes that the filename is foo/meson.build
-    const std::filesystem::path _p{held->loc.filename};
+    const std::filesystem::path _p{held->loc.filename()};
     const std::filesystem::path p{_p.parent_path() / dir->value / "meson.build"};
     if (!std::filesystem::exists(p)) {
         // TODO: use the location data.
@@ -90,20 +58,84 @@ SubdirVisitor::operator()(const std::unique_ptr<Statement> & stmt) const {
                                                  "."};
     }
 
+    return p;
+}
+
+void find_subdir_files(const CodeBlock & block, std::vector<std::filesystem::path> & files) {
+    for (const auto & stmt : block.statements) {
+        if (const auto * s = std::get_if<std::unique_ptr<Statement>>(&stmt)) {
+            if (auto p = subdir_file(**s)) {
+                files.emplace_back(std::move(p.value()));
+            }
+        } else if (const auto * i = std::get_if<std::unique_ptr<IfStatement>>(&stmt)) {
+            const auto & ifs = **i;
+            find_subdir_files(*ifs.ifblock.block, files);
+            for (const auto & s : ifs.efblock) {
+                find_subdir_files(*s.block, files);
+            }
+            if (ifs.eblock.block) {
+                find_subdir_files(*ifs.eblock.block, files);
+            }
+        }
+    }
+}
+
+void replace_subdirs(CodeBlock & block, const SubdirVisitor & sv) {
+    std::vector<StatementV> new_stmts{};
+
+    for (auto && stmt : block.statements) {
+        auto res = std::visit(sv, stmt);
+
+        // If we have a value that means that a `subdir()` call was
+        // encounted, we then wnat to add the staements from that call into
+        // our new statements instead of the current `subdir()` call.
+        // Otherwise just move the statement.
+        if (res.has_value()) {
+            auto & v = res.value();
+            std::move(v->statements.begin(), v->statements.end(), std::back_inserter(new_stmts));
+            std::move(v->sources.begin(), v->sources.end(), std::back_inserter(block.sources));
+            std::move(v->arenas.begin(), v->arenas.end(), std::back_inserter(block.arenas));
+        } else {
+            new_stmts.emplace_back(std::move(stmt));
+        }
+    }
+
+    block.statements = std::move(new_stmts);
+}
+
+std::optional<std::unique_ptr<CodeBlock>>
+SubdirVisitor::operator()(const std::unique_ptr<Statement> & stmt) const {
+    auto p = subdir_file(*stmt);
+    if (!p) {
+        return std::nullopt;
+    }
+
+    // If the file has already been parsed take it, it only needs to have it's
+    // own subdir() calls replaced. A file can only be taken once, if the same
+    // directory is entered twice the second one is parsed again.
+    if (parsed != nullptr) {
+        if (auto it = parsed->find(p.value()); it != parsed->end() && it->second != nullptr) {
+            auto block = std::move(it->second);
+            replace_subdirs(*block, *this);
+            return block;
+        }
+    }
+
     Driver drv{};
-    return drv.parse(p);
+    drv.cache = cache;
+    return drv.parse(p.value());
 };
 
 std::optional<std::unique_ptr<CodeBlock>>
 SubdirVisitor::operator()(const std::unique_ptr<IfStatement> & stmt) const {
-    subdir_replacer(stmt->ifblock.block);
+    replace_subdirs(*stmt->ifblock.block, *this);
     if (!stmt->efblock.empty()) {
         for (auto & s : stmt->efblock) {
-            subdir_replacer(s.block);
+            replace_subdirs(*s.block, *this);
         }
     }
     if (stmt->eblock.block) {
-        subdir_replacer(stmt->eblock.block);
+        replace_subdirs(*stmt->eblock.block, *this);
     }
 
     // XXX: this is kinda gross...
@@ -15,10 +15,13 @@
 #include "state/state.hpp"
 #include "tools/test.hpp"
 #include "tools/vcs_tag.hpp"
+#include "trace.hpp"
 #include "version.hpp"
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -60,23 +63,61 @@ int configure(const Options::ConfigureOptions & opts) {
               << "Source dir: " << Util::Log::bold(fs::absolute(opts.sourcedir)) << std::endl
               << "Build dir: " << Util::Log::bold(fs::absolute(opts.builddir)) << std::endl;
 
-    // Parse the source into a an AST
-    Frontend::Driver drv{};
-    auto block = drv.parse(opts.sourcedir / "meson.build");
+    if (!opts.trace.empty()) {
+        Util::Trace::start(opts.trace);
+    }
+
+    // Parse the source into a an AST, parsing subdirectories in parallel
+    Frontend::Driver drv{std::max(std::thread::hardware_concurrency(), 1U)};
+
+    // Files that haven't changed since the last configure are loaded from
+    // the cache instead of being parsed again
+    const Frontend::Cache cache{opts.builddir / "ast-cache", version::VERSION};
+    drv.cache = &cache;
 
     MIR::State::Persistant pstate{opts.sourcedir, opts.builddir, opts.program};
 
     // Create IR from the AST, then run our lowering passes on it
-    MIR::CFG irlist = MIR::lower_ast(block, pstate);
-    MIR::Passes::lower_project(irlist.root, pstate);
-    MIR::lower(irlist.root, pstate);
+    MIR::CFG irlist = [&] {
+        const std::string root = opts.sourcedir / "meson.build";
+        if (opts.streaming) {
+            // Lower each statement as it's parsed, so the AST for the whole
+            // project is never in memory at once
+            Util::Trace::Scope trace{"configure", "lower_ast"};
+            return MIR::lower_ast(
+                [&](const Frontend::AST::StatementSink & sink) { drv.parse(root, sink); },
+                pstate);
+        }
+        auto block = [&] {
+            Util::Trace::Scope trace{"configure", "parse"};
+            return drv.parse(root);
+        }();
+        Util::Trace::Scope trace{"configure", "lower_ast"};
+        return MIR::lower_ast(block, pstate);
+    }();
+    // Every file has been read now, so drop the entries that weren't used
+    cache.prune();
+
+    {
+        Util::Trace::Scope trace{"configure", "lower_project"};
+        MIR::Passes::lower_project(irlist.root, pstate);
+    }
+    {
+        Util::Trace::Scope trace{"configure", "lower"};
+        MIR::lower(irlist.root, pstate);
+    }
 
     const bool errors = emit_messages(*irlist.root);
     if (errors) {
         throw Util::Exceptions::MesonException("Configure failed with errors.");
     }
 
-    Backends::Ninja::generate(*irlist.root, pstate);
+    {
+        Util::Trace::Scope trace{"configure", "ninja"};
+        Backends::Ninja::generate(*irlist.root, pstate);
+    }
+
+    Util::Trace::finish();
 
     return 0;
 };
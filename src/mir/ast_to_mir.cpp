@@ -2,9 +2,11 @@
 // Copyright © 2024-2025 Intel Corporation
 
 #include <filesystem>
+#include <vector>
 
 #include "ast_to_mir.hpp"
 #include "exceptions.hpp"
+#include "paths.hpp"
 
 namespace fs = std::filesystem;
 
@@ -13,22 +15,55 @@ namespace MIR {
 namespace {
 
 /// Get just the subdir, without the source_root
-fs::path get_subdir(const fs::path & full_path, const State::Persistant & pstate) {
+const fs::path & get_subdir(const fs::path & full_path, const State::Persistant & pstate) {
     // This works for our case, but is probably wrong in a generic sense
-    return fs::relative(full_path, pstate.source_root).parent_path();
+    const fs::path & subdir = Util::Paths::relative(full_path.parent_path(), pstate.source_root);
+
+    // The source root itself is ".", but its subdir is empty
+    static const fs::path root{};
+    return subdir == "." ? root : subdir;
 }
 
+/**
+ * The subdir of each file, by file id
+ *
+ * The paths themselves are interned by Util::Paths, this only saves looking
+ * them up again for every node of a file.
+ */
+class SubdirTable {
+  public:
+    explicit SubdirTable(const State::Persistant & ps) : pstate{ps} {};
+
+    const fs::path & get(const Frontend::AST::Location & loc) {
+        if (loc.file >= subdirs.size()) {
+            subdirs.resize(loc.file + 1, nullptr);
+        }
+        auto & subdir = subdirs[loc.file];
+        if (subdir == nullptr) {
+            subdir = &get_subdir(fs::path{loc.filename()}, pstate);
+        }
+        return *subdir;
+    }
+
+  private:
+    const State::Persistant & pstate;
+
+    std::vector<const fs::path *> subdirs{};
+};
+
 /**
  * Lowers AST expressions into MIR objects.
  */
 struct ExpressionLowering {
 
-    explicit ExpressionLowering(const MIR::State::Persistant & ps) : pstate{ps} {};
+    ExpressionLowering(const MIR::State::Persistant & ps, SubdirTable & sd)
+        : pstate{ps}, subdirs{sd} {};
 
     const MIR::State::Persistant & pstate;
+    SubdirTable & subdirs;
 
     Object operator()(const std::unique_ptr<Frontend::AST::String> & expr) const {
-        return std::make_shared<String>(expr->value);
+        return String::intern(expr->value);
     };
 
     Object operator()(const std::unique_ptr<Frontend::AST::FunctionCall> & expr) const {
@@ -49,7 +84,7 @@ struct ExpressionLowering {
             pos.emplace_back(std::visit(*this, i));
         }
 
-        std::unordered_map<std::string, Object> kwargs{};
+        ObjectMap kwargs{};
         for (const auto & [k, v] : expr->args->keyword) {
             auto key_obj = std::visit(*this, k);
             try {
@@ -61,27 +96,26 @@ struct ExpressionLowering {
             }
         }
 
-        const fs::path subdir = get_subdir(fs::path{expr->loc.filename}, pstate);
+        const fs::path & subdir = subdirs.get(expr->loc);
 
         // We have to move positional arguments because Object isn't copy-able
         // TODO: filename is currently absolute, but we need the source dir to make it relative
-        return std::make_shared<FunctionCall>(fname, std::move(pos), std::move(kwargs),
-                                              std::move(subdir));
+        return std::make_shared<FunctionCall>(fname, std::move(pos), std::move(kwargs), subdir);
     };
 
     Object operator()(const std::unique_ptr<Frontend::AST::Boolean> & expr) const {
-        return std::make_shared<Boolean>(expr->value);
+        return Boolean::intern(expr->value);
     };
 
     Object operator()(const std::unique_ptr<Frontend::AST::Number> & expr) const {
-        return std::make_shared<Number>(expr->value);
+        return Number::intern(expr->value);
     };
 
     Object operator()(const std::unique_ptr<Frontend::AST::Identifier> & expr) const {
         if (expr->value == "meson") {
             return std::make_shared<Meson>();
         }
-        return std::make_shared<Identifier>(expr->value);
+        return std::make_shared<Identifier>(std::string{expr->value});
     };
 
     Object operator()(const std::unique_ptr<Frontend::AST::Array> & expr) const {
@@ -140,7 +174,7 @@ struct ExpressionLowering {
                 throw std::exception{}; // Should be unreachable
         }
 
-        fs::path path = get_subdir(fs::path{expr->loc.filename}, pstate);
+        const fs::path & path = subdirs.get(expr->loc);
         std::vector<Object> pos{};
         pos.emplace_back(std::visit(*this, expr->rhs));
 
@@ -191,7 +225,7 @@ struct ExpressionLowering {
                 func_name = "not_contains";
                 break;
         }
-        fs::path path = get_subdir(fs::path{expr->loc.filename}, pstate);
+        const fs::path & path = subdirs.get(expr->loc);
 
         return std::make_shared<FunctionCall>(func_name, std::move(pos), path);
     };
@@ -206,14 +240,16 @@ struct ExpressionLowering {
  */
 struct StatementLowering {
 
-    explicit StatementLowering(const MIR::State::Persistant & ps) : pstate{ps} {};
+    StatementLowering(const MIR::State::Persistant & ps, SubdirTable & sd)
+        : pstate{ps}, subdirs{sd} {};
 
     const MIR::State::Persistant & pstate;
+    SubdirTable & subdirs;
 
     std::shared_ptr<CFGNode>
     operator()(std::shared_ptr<CFGNode> list,
                const std::unique_ptr<Frontend::AST::Statement> & stmt) const {
-        const ExpressionLowering l{pstate};
+        const ExpressionLowering l{pstate, subdirs};
         list->block->instructions.emplace_back(std::visit(l, stmt->expr));
         return list;
     };
@@ -222,7 +258,7 @@ struct StatementLowering {
     operator()(std::shared_ptr<CFGNode> head,
                const std::unique_ptr<Frontend::AST::IfStatement> & stmt) const {
         assert(head);
-        const ExpressionLowering l{pstate};
+        const ExpressionLowering l{pstate, subdirs};
 
         // TODO: we could optimize here by deciding if we have any elif/else
         // statements, and using a predicated jump?
@@ -290,7 +326,7 @@ struct StatementLowering {
     std::shared_ptr<CFGNode>
     operator()(std::shared_ptr<CFGNode> list,
                const std::unique_ptr<Frontend::AST::Assignment> & stmt) const {
-        const ExpressionLowering l{pstate};
+        const ExpressionLowering l{pstate, subdirs};
         auto target = std::visit(l, stmt->lhs);
         auto value = std::visit(l, stmt->rhs);
 
@@ -338,7 +374,8 @@ CFG lower_ast(const std::unique_ptr<Frontend::AST::CodeBlock> & block,
               const MIR::State::Persistant & pstate) {
     auto root_block = std::make_shared<CFGNode>();
     auto current_block = root_block;
-    const StatementLowering lower{pstate};
+    SubdirTable subdirs{pstate};
+    const StatementLowering lower{pstate, subdirs};
     for (const auto & i : block->statements) {
         current_block = std::visit([&](const auto & a) { return lower(current_block, a); }, i);
     }
@@ -346,4 +383,17 @@ CFG lower_ast(const std::unique_ptr<Frontend::AST::CodeBlock> & block,
     return CFG{root_block};
 }
 
+CFG lower_ast(const std::function<void(const Frontend::AST::StatementSink &)> & parse,
+              const MIR::State::Persistant & pstate) {
+    auto root_block = std::make_shared<CFGNode>();
+    auto current_block = root_block;
+    SubdirTable subdirs{pstate};
+    const StatementLowering lower{pstate, subdirs};
+    parse([&](Frontend::AST::StatementV stmt) {
+        current_block = std::visit([&](const auto & a) { return lower(current_block, a); }, stmt);
+    });
+
+    return CFG{root_block};
+}
+
 } // namespace MIR
@@ -7,6 +7,7 @@
 #include "node.hpp"
 #include "state/state.hpp"
 
+#include <functional>
 #include <memory>
 
 namespace MIR {
@@ -14,4 +15,16 @@ namespace MIR {
 /// Lower AST to IR
 CFG lower_ast(const std::unique_ptr<Frontend::AST::CodeBlock> &, const MIR::State::Persistant &);
 
+/**
+ * Lower AST to IR one statement at a time, as it is parsed
+ *
+ * Each statement is lowered as soon as it is produced and then freed, so the
+ * AST for the whole project is never held in memory.
+ *
+ * @param parse Parses the project, passing each top level statement to the
+ *              sink, see Frontend::Driver::parse
+ */
+CFG lower_ast(const std::function<void(const Frontend::AST::StatementSink &)> & parse,
+              const MIR::State::Persistant &);
+
 }; // namespace MIR
@@ -5,98 +5,128 @@
 
 #include "lower.hpp"
 #include "passes/private.hpp"
+#include "trace.hpp"
 
 namespace MIR {
 
 namespace {
 
+/// Most of the lowering passes only act on function and method calls
+constexpr Passes::ObjectMask function_calls = Passes::object_mask<FunctionCallPtr>();
+
 // Early lowering
 //
 // Some passes just only need to be run once for the whole program,
-// lowering `*_machine`, and doing our global value numbering and phi
-// insertion pass
+// lowering `*_machine`, doing our global value numbering and phi insertion
+// pass, and replacing repeated calls to pure functions
 // TODO: compilers may need to be run again if `add_language` is called
 void early(std::shared_ptr<MIR::CFGNode> block, State::Persistant & pstate,
-           Passes::Printer & printer) {
+           Passes::Printer & printer, Passes::PassTimer & timer) {
+    Util::Trace::Scope trace{"mir", "early"};
+    timer.iteration("early");
     Passes::graph_walker(
-        block, {
-                   [&](std::shared_ptr<CFGNode> b) {
-                       return Passes::instruction_walker(
-                           *b,
-                           {
-                               Passes::custom_target_program_replacement,
-                           },
-                           {
-                               [&pstate](const Object & obj) {
-                                   return Passes::insert_compilers(obj, pstate.toolchains);
-                               },
-                               [&pstate](const Object & obj) {
-                                   return Passes::machine_lower(obj, pstate.machines);
+        block,
+        {
+            timer.wrap("early lowering",
+                       [&](const std::shared_ptr<CFGNode> & b) {
+                           return Passes::instruction_walker(
+                               *b,
+                               {
+                                   Passes::custom_target_program_replacement,
                                },
-                           });
-                   },
-                   Passes::GlobalValueNumbering{},
-                   std::ref(printer),
-               });
+                               {
+                                   {[&pstate](const Object & obj) {
+                                        return Passes::insert_compilers(obj, pstate.toolchains);
+                                    },
+                                    function_calls},
+                                   {[&pstate](const Object & obj) {
+                                        return Passes::machine_lower(obj, pstate.machines);
+                                    },
+                                    function_calls},
+                               });
+                       }),
+            timer.wrap("global_value_numbering", Passes::GlobalValueNumbering{}),
+            timer.wrap("common_subexpressions", Passes::CommonSubexpressions{}),
+            std::ref(printer),
+        });
 }
 
 void main(std::shared_ptr<MIR::CFGNode> block, State::Persistant & pstate,
-          Passes::Printer & printer) {
-    const std::vector<MIR::Passes::BlockWalkerCb> main_loop{
-        [&](std::shared_ptr<CFGNode> b) {
+          Passes::Printer & printer, Passes::PassTimer & timer) {
+    Passes::PassManager main_loop{{
+        timer.wrap("lowering", [&](const std::shared_ptr<CFGNode> & b) {
             return Passes::instruction_walker(
                 *b, {
-                        Passes::disable,
-                        Passes::flatten,
-                        [&pstate](const Object & i) {
-                            return Passes::lower_free_functions(i, pstate);
-                        },
-                        [&pstate](const Object & i) {
-                            return Passes::lower_program_objects(i, pstate);
-                        },
-                        [&pstate](const Object & i) {
-                            return Passes::lower_string_objects(i, pstate);
-                        },
-                        [&pstate](const Object & i) {
-                            return Passes::lower_dependency_objects(i, pstate);
-                        },
+                        {Passes::disable,
+                         Passes::object_mask<ArrayPtr, DictPtr, FunctionCallPtr, JumpPtr,
+                                             BranchPtr, DisablerPtr>()},
+                        {Passes::flatten, Passes::object_mask<ArrayPtr>()},
+                        {[&pstate](const Object & i) {
+                             return Passes::lower_free_functions(i, pstate);
+                         },
+                         function_calls},
+                        {[&pstate](const Object & i) {
+                             return Passes::lower_program_objects(i, pstate);
+                         },
+                         function_calls},
+                        {[&pstate](const Object & i) {
+                             return Passes::lower_string_objects(i, pstate);
+                         },
+                         function_calls},
+                        {[&pstate](const Object & i) {
+                             return Passes::lower_dependency_objects(i, pstate);
+                         },
+                         function_calls},
                     });
-        },
-        Passes::delete_unreachable,
-        Passes::ConstantFolding{},
-        Passes::ConstantPropagation{},
-        Passes::branch_pruning,
-        Passes::join_blocks,
-        Passes::fixup_phis,
-        std::ref(printer),
+        }),
+        timer.wrap("delete_unreachable", Passes::delete_unreachable),
+        timer.wrap("constant_folding", Passes::ConstantFolding{}),
+        timer.wrap("constant_propagation", Passes::ConstantPropagation{}),
+        timer.wrap("branch_pruning", Passes::branch_pruning),
+        timer.wrap("join_blocks", Passes::join_blocks),
+        timer.wrap("fixup_phis", Passes::fixup_phis),
+    }};
+
+    // The pass manager only walks the blocks that changed, so the printer is
+    // run separately to dump the whole program after each iteration
+    const auto & run = [&]() {
+        bool progress;
+        do {
+            Util::Trace::Scope trace{"mir", "main iteration"};
+            printer.increment();
+            timer.iteration("main");
+            progress = main_loop(block);
+            Passes::graph_walker(block, {std::ref(printer)});
+        } while (progress);
     };
 
-    bool progress = false;
-    do {
-        printer.increment();
-        progress = Passes::graph_walker(block, std::ref(main_loop));
-    } while (progress);
+    run();
 
     // Run the main lowering loop until it cannot lower any more, then do the
     // threaded lowering, which we run across the entire program to lower things
     // like find_program(), Then run the main loop again until we've lowered it
     // all away
-    if (Passes::threaded_lowering(block, pstate)) {
-        do {
-            printer.increment();
-            progress = Passes::graph_walker(block, std::ref(main_loop));
-        } while (progress);
+    timer.iteration("threaded");
+    const bool threaded = [&] {
+        Util::Trace::Scope trace{"mir", "threaded_lowering"};
+        return Passes::threaded_lowering(block, pstate, timer);
+    }();
+    if (threaded) {
+        main_loop.invalidate();
+        run();
     }
 }
 
 void late(std::shared_ptr<MIR::CFGNode> block, State::Persistant & pstate,
-          Passes::Printer & printer) {
+          Passes::Printer & printer, Passes::PassTimer & timer) {
     const std::vector<MIR::Passes::BlockWalkerCb> loop{
-        MIR::Passes::combine_add_arguments,
+        timer.wrap("combine_add_arguments", MIR::Passes::combine_add_arguments),
         std::ref(printer),
     };
 
+    Util::Trace::Scope trace{"mir", "late"};
     printer.increment();
+    timer.iteration("late");
     Passes::graph_walker(block, std::ref(loop));
 }
 
@@ -108,9 +138,14 @@ void lower(std::shared_ptr<CFGNode> block, State::Persistant & pstate) {
     printer(block);
     printer.increment();
 
-    early(block, pstate, printer);
-    main(block, pstate, printer);
-    late(block, pstate, printer);
+    Passes::PassTimer timer{};
+
+    early(block, pstate, printer, timer);
+    main(block, pstate, printer, timer);
+    late(block, pstate, printer, timer);
+
+    // Don't keep the blocks alive after the graph is done with
+    Passes::CFGAnalysis::reset();
 }
 
 } // namespace MIR
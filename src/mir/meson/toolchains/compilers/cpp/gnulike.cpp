@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright © 2021-2024 Intel Corporation
 
+#include "paths.hpp"
 #include "toolchains/compilers/cpp/cpp.hpp"
 
 namespace MIR::Toolchain::Compiler::CPP {
@@ -67,7 +68,8 @@ std::vector<std::string> GnuLike::specialize_argument(const Arguments::Argument
                 default:
                     throw std::exception{}; // Should be unreachable
             }
-            std::string b_inc = "'" + std::string{fs::relative(arg.value(), build_dir)} + "'";
+            std::string b_inc =
+                "'" + std::string{Util::Paths::relative(arg.value(), build_dir)} + "'";
             if (b_inc == "''") {
                 b_inc = ".";
             }
@@ -75,7 +77,7 @@ std::vector<std::string> GnuLike::specialize_argument(const Arguments::Argument
             args.emplace_back(b_inc);
             args.emplace_back(inc_arg);
             // Needs to be relative to build dir
-            args.emplace_back(fs::relative(src_dir / arg.value(), build_dir));
+            args.emplace_back(Util::Paths::relative(src_dir / arg.value(), build_dir));
             return args;
         }
         case Arguments::Type::RAW:
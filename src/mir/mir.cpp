@@ -2,17 +2,28 @@
 // Copyright © 2021-2025 Intel Corporation
 
 #include <algorithm>
+#include <array>
+#include <deque>
 #include <iterator>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 
 #include "exceptions.hpp"
 #include "mir.hpp"
+#include "paths.hpp"
 
 namespace MIR {
 
 namespace {
 
 uint32_t bb_index = 0;
+uint64_t cfg_edits = 0;
 
 std::string join(const std::vector<std::string> & vec, const char * delim = ", ") {
     std::stringstream stream{};
@@ -71,10 +82,10 @@ std::string to_string(const std::vector<FilePtr> & args) {
     return join(vec);
 }
 
-std::string to_string(const std::unordered_map<std::string, Object> & map) {
+std::string to_string(const ObjectMap & map) {
     std::vector<std::string> args{};
     std::transform(map.begin(), map.end(), std::back_inserter(args),
-                   [](const std::pair<const std::string, const Object> & p) {
+                   [](ObjectMap::const_reference p) {
                        return p.first + " : " + printer(p.second);
                    });
     return join(args);
@@ -127,9 +138,77 @@ std::string Compiler::print() const {
            "; id = " + toolchain->compiler->id() + " }";
 }
 
+/**
+ * An interned name and its id
+ */
+struct Symbol::Entry {
+    std::string name;
+    uint32_t id;
+};
+
+namespace {
+
+struct SymbolTable {
+    std::shared_mutex lock{};
+
+    /// A deque, as it never moves elements when growing
+    std::deque<Symbol::Entry> entries{};
+
+    /// Views into the entries
+    std::unordered_map<std::string_view, const Symbol::Entry *> lookup{};
+};
+
+SymbolTable & symbol_table() {
+    static SymbolTable table{};
+    return table;
+}
+
+const std::string empty_symbol{};
+
+} // namespace
+
+Symbol::Symbol(std::string_view s) {
+    if (s.empty()) {
+        return;
+    }
+
+    auto & table = symbol_table();
+    {
+        std::shared_lock<std::shared_mutex> guard{table.lock};
+        if (auto it = table.lookup.find(s); it != table.lookup.end()) {
+            entry = it->second;
+            return;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> guard{table.lock};
+    // Another thread may have added it while the lock was released
+    if (auto it = table.lookup.find(s); it != table.lookup.end()) {
+        entry = it->second;
+        return;
+    }
+    // 0 is reserved for the empty Symbol
+    const auto id = static_cast<uint32_t>(table.entries.size() + 1);
+    const auto & e = table.entries.emplace_back(Entry{std::string{s}, id});
+    table.lookup.emplace(e.name, &e);
+    entry = &e;
+}
+
+const std::string & Symbol::str() const { return entry != nullptr ? entry->name : empty_symbol; }
+
+uint32_t Symbol::id() const { return entry != nullptr ? entry->id : 0; }
+
+uint32_t Symbol::count() {
+    auto & table = symbol_table();
+    std::shared_lock<std::shared_mutex> guard{table.lock};
+    return static_cast<uint32_t>(table.entries.size() + 1);
+}
+
+std::ostream & operator<<(std::ostream & os, const Symbol & s) { return os << s.str(); }
+
 Variable::Variable() : gvn{0} {};
-Variable::Variable(std::string n) : name{std::move(n)}, gvn{0} {};
-Variable::Variable(std::string n, const uint32_t & v) : name{std::move(n)}, gvn{v} {};
+Variable::Variable(Symbol n) : name{n}, gvn{0} {};
+Variable::Variable(Symbol n, const uint32_t & v) : name{n}, gvn{v} {};
 
 Variable::operator bool() const { return !name.empty(); };
 
@@ -141,51 +220,74 @@ bool Variable::operator==(const Variable & other) const {
     return name == other.name && gvn == other.gvn;
 }
 
+bool Variable::operator!=(const Variable & other) const { return !(*this == other); }
+
 std::string Variable::print() const {
-    return "Variable { name = " + name + "; gvn = " + to_string(gvn) + " }";
+    return "Variable { name = " + name.str() + "; gvn = " + to_string(gvn) + " }";
 }
 
-File::File(std::string name_, fs::path sdir, const bool & built_, fs::path sr_, fs::path br_)
-    : name{std::move(name_)}, subdir{std::move(sdir)}, built{built_}, source_root{std::move(sr_)},
-      build_root{std::move(br_)} {};
-
-bool File::is_built() const { return built; }
-
-std::string File::get_name() const { return name; }
+namespace {
 
-std::filesystem::path File::relative_to_source_dir() const {
-    if (built) {
-        std::error_code ec{};
-        auto p = fs::relative(build_root / subdir / name, source_root / subdir, ec);
-        if (ec) {
-            // TODO: better error handling
-            throw Util::Exceptions::MesonException{"Failed to create relative path"};
-        }
-        return p;
+const fs::path & relative_dir(const fs::path & p, const fs::path & base) {
+    try {
+        return Util::Paths::relative(p, base);
+    } catch (const fs::filesystem_error &) {
+        // TODO: better error handling
+        throw Util::Exceptions::MesonException{"Failed to create relative path"};
     }
-    return subdir / name;
 }
 
-std::filesystem::path File::relative_to_build_dir() const {
-    if (!built) {
-        std::error_code ec{};
-        auto p = fs::relative(source_root / subdir / name, build_root / subdir, ec);
-        if (ec) {
-            // TODO: better error handling
-            throw Util::Exceptions::MesonException{"Failed to create relative path"};
-        }
-        return p;
+} // namespace
+
+Directory::Directory(const fs::path & sdir, const fs::path & sr_, const fs::path & br_)
+    : subdir{Util::Paths::intern(sdir)}, source_root{Util::Paths::intern(sr_)},
+      build_root{Util::Paths::intern(br_)},
+      source_from_build{relative_dir(source_root / subdir, build_root / subdir)},
+      build_from_source{relative_dir(build_root / subdir, source_root / subdir)} {};
+
+DirectoryPtr Directory::intern(const fs::path & subdir, const fs::path & source_root,
+                               const fs::path & build_root) {
+    using Key = std::tuple<fs::path::string_type, fs::path::string_type, fs::path::string_type>;
+    static std::mutex lock{};
+    /// Transparent, so that looking up a Directory does not copy the paths
+    static std::map<Key, DirectoryPtr, std::less<>> table{};
+
+    std::lock_guard<std::mutex> guard{lock};
+    const auto key = std::tie(subdir.native(), source_root.native(), build_root.native());
+    if (auto it = table.find(key); it != table.end()) {
+        return it->second;
     }
-    return subdir / name;
+    auto dir = std::make_shared<const Directory>(subdir, source_root, build_root);
+    table.emplace(key, dir);
+    return dir;
 }
 
+File::File(std::string name_, DirectoryPtr dir, const bool & built_)
+    : name{std::move(name_)}, directory{std::move(dir)}, built{built_},
+      source_relative{built ? (directory->build_from_source / name).lexically_normal()
+                            : directory->subdir / name},
+      build_relative{built ? directory->subdir / name
+                           : (directory->source_from_build / name).lexically_normal()} {};
+
+File::File(std::string name_, const fs::path & sdir, const bool & built_, const fs::path & sr_,
+           const fs::path & br_)
+    : File{std::move(name_), Directory::intern(sdir, sr_, br_), built_} {};
+
+bool File::is_built() const { return built; }
+
+std::string File::get_name() const { return name; }
+
+const fs::path & File::relative_to_source_dir() const { return source_relative; }
+
+const fs::path & File::relative_to_build_dir() const { return build_relative; }
+
 bool File::operator==(const File & f) const {
-    return subdir / name == f.subdir / f.name && built == f.built;
+    // For each kind of file, one of these is the subdir and name
+    return built == f.built &&
+           (built ? build_relative == f.build_relative : source_relative == f.source_relative);
 }
 
-bool File::operator!=(const File & f) const {
-    return subdir / name != f.subdir / f.name || built != f.built;
-}
+bool File::operator!=(const File & f) const { return !(*this == f); }
 
 bool File::is_reduced() const { return true; }
 
@@ -195,7 +297,8 @@ std::string File::print() const {
 }
 
 std::ostream & operator<<(std::ostream & os, const File & f) {
-    return os << (f.is_built() ? f.build_root : f.source_root) / f.subdir / f.get_name();
+    const auto & dir = *f.directory;
+    return os << (f.is_built() ? dir.build_root : dir.source_root) / dir.subdir / f.get_name();
 }
 
 Executable::Executable(std::string name_, std::vector<Object> srcs, const Machines::Machine & m,
@@ -259,19 +362,98 @@ std::string Program::print() const {
 
 bool Program::found() const { return path != ""; }
 
+namespace {
+
+struct BuiltinName {
+    std::string_view name;
+    Builtin id;
+};
+
+/// Sorted by name, so it can be binary searched
+constexpr std::array builtin_names{
+    BuiltinName{"add_global_arguments", Builtin::ADD_GLOBAL_ARGUMENTS},
+    BuiltinName{"add_global_link_arguments", Builtin::ADD_GLOBAL_LINK_ARGUMENTS},
+    BuiltinName{"add_project_arguments", Builtin::ADD_PROJECT_ARGUMENTS},
+    BuiltinName{"add_project_link_arguments", Builtin::ADD_PROJECT_LINK_ARGUMENTS},
+    BuiltinName{"assert", Builtin::ASSERT},
+    BuiltinName{"cpu", Builtin::CPU},
+    BuiltinName{"cpu_family", Builtin::CPU_FAMILY},
+    BuiltinName{"custom_target", Builtin::CUSTOM_TARGET},
+    BuiltinName{"declare_dependency", Builtin::DECLARE_DEPENDENCY},
+    BuiltinName{"dependency", Builtin::DEPENDENCY},
+    BuiltinName{"disabler", Builtin::DISABLER},
+    BuiltinName{"endian", Builtin::ENDIAN},
+    BuiltinName{"error", Builtin::ERROR},
+    BuiltinName{"executable", Builtin::EXECUTABLE},
+    BuiltinName{"files", Builtin::FILES},
+    BuiltinName{"find_program", Builtin::FIND_PROGRAM},
+    BuiltinName{"found", Builtin::FOUND},
+    BuiltinName{"get_compiler", Builtin::GET_COMPILER},
+    BuiltinName{"get_id", Builtin::GET_ID},
+    BuiltinName{"include_directories", Builtin::INCLUDE_DIRECTORIES},
+    BuiltinName{"message", Builtin::MESSAGE},
+    BuiltinName{"name", Builtin::NAME},
+    BuiltinName{"project", Builtin::PROJECT},
+    BuiltinName{"rel_eq", Builtin::REL_EQ},
+    BuiltinName{"rel_ne", Builtin::REL_NE},
+    BuiltinName{"static_library", Builtin::STATIC_LIBRARY},
+    BuiltinName{"system", Builtin::SYSTEM},
+    BuiltinName{"test", Builtin::TEST},
+    BuiltinName{"unary_neg", Builtin::UNARY_NEG},
+    BuiltinName{"unary_not", Builtin::UNARY_NOT},
+    BuiltinName{"vcs_tag", Builtin::VCS_TAG},
+    BuiltinName{"version", Builtin::VERSION},
+    BuiltinName{"version_compare", Builtin::VERSION_COMPARE},
+    BuiltinName{"warning", Builtin::WARNING},
+};
+
+constexpr bool builtin_names_sorted() {
+    for (size_t i = 1; i < builtin_names.size(); ++i) {
+        if (!(builtin_names[i - 1].name < builtin_names[i].name)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(builtin_names_sorted(), "builtin_names must be sorted by name");
+static_assert(builtin_names.size() + 1 == builtin_count, "every Builtin except UNKNOWN has a name");
+
+} // namespace
+
+Builtin builtin_id(std::string_view name) {
+    const auto it =
+        std::lower_bound(builtin_names.begin(), builtin_names.end(), name,
+                         [](const BuiltinName & b, std::string_view n) { return b.name < n; });
+    if (it != builtin_names.end() && it->name == name) {
+        return it->id;
+    }
+    return Builtin::UNKNOWN;
+}
+
 FunctionCall::FunctionCall(std::string _name, std::vector<Object> && _pos,
-                           std::unordered_map<std::string, Object> && _kw,
-                           std::filesystem::path _sd)
-    : name{std::move(_name)}, pos_args{std::move(_pos)}, kw_args{std::move(_kw)},
-      holder{std::nullopt}, source_dir{std::move(_sd)} {};
+                           ObjectMap && _kw, std::filesystem::path _sd)
+    : name{std::move(_name)}, id{builtin_id(name)}, pos_args{std::move(_pos)},
+      kw_args{std::move(_kw)}, holder{std::nullopt}, source_dir{std::move(_sd)} {};
 
 FunctionCall::FunctionCall(std::string _name, std::vector<Object> && _pos,
                            std::filesystem::path _sd)
-    : name{std::move(_name)}, pos_args{std::move(_pos)}, holder{std::nullopt},
-      source_dir{std::move(_sd)} {};
+    : name{std::move(_name)}, id{builtin_id(name)}, pos_args{std::move(_pos)},
+      holder{std::nullopt}, source_dir{std::move(_sd)} {};
 
 bool FunctionCall::is_reduced() const { return false; }
 
+bool FunctionCall::args_reduced() const {
+    if (!reduced) {
+        const auto & r = [](const Object & obj) {
+            return std::visit([](auto && o) { return o->is_reduced(); }, obj);
+        };
+        reduced = std::all_of(pos_args.begin(), pos_args.end(), r) &&
+                  std::all_of(kw_args.begin(), kw_args.end(),
+                              [&r](auto && kw) { return r(kw.second); });
+    }
+    return reduced;
+}
+
 std::string FunctionCall::print() const {
     std::stringstream ss{};
     ss << "FunctionCall { name = { " + name + " };";
@@ -293,9 +475,24 @@ bool String::is_reduced() const { return true; }
 
 std::string String::print() const { return "'" + value + "'"; }
 
-bool String::operator!=(const String & o) const { return value != o.value; }
+bool String::operator!=(const String & o) const { return !(*this == o); }
+
+bool String::operator==(const String & o) const { return this == &o || value == o.value; }
 
-bool String::operator==(const String & o) const { return value == o.value; }
+StringPtr String::intern(std::string_view v) {
+    static std::mutex lock{};
+    /// The keys are views into the values of the nodes
+    static std::unordered_map<std::string_view, StringPtr> table{};
+
+    std::lock_guard<std::mutex> guard{lock};
+    if (auto it = table.find(v); it != table.end()) {
+        return it->second;
+    }
+    auto str = std::make_shared<String>(std::string{v});
+    str->interned = true;
+    table.emplace(str->value, str);
+    return str;
+}
 
 Boolean::Boolean(const bool & f) : value{f} {};
 
@@ -306,6 +503,18 @@ std::string Boolean::print() const { return value ? "true" : "false"; }
 bool Boolean::operator!=(const Boolean & o) const { return value != o.value; }
 bool Boolean::operator==(const Boolean & o) const { return value == o.value; }
 
+BooleanPtr Boolean::intern(bool v) {
+    static const std::array<BooleanPtr, 2> values = [] {
+        std::array<BooleanPtr, 2> bs{std::make_shared<Boolean>(false),
+                                     std::make_shared<Boolean>(true)};
+        for (auto & b : bs) {
+            b->interned = true;
+        }
+        return bs;
+    }();
+    return values[v];
+}
+
 Number::Number(const int64_t & f) : value{f} {};
 
 bool Number::is_reduced() const { return true; }
@@ -315,31 +524,50 @@ std::string Number::print() const { return to_string(value); }
 bool Number::operator!=(const Number & o) const { return value != o.value; }
 bool Number::operator==(const Number & o) const { return value == o.value; }
 
-Identifier::Identifier(std::string s) : value{std::move(s)}, version{} {};
-Identifier::Identifier(std::string s, const uint32_t & ver) : value{std::move(s)}, version{ver} {};
+NumberPtr Number::intern(int64_t v) {
+    static std::mutex lock{};
+    static std::unordered_map<int64_t, NumberPtr> table{};
+
+    std::lock_guard<std::mutex> guard{lock};
+    auto & num = table[v];
+    if (!num) {
+        num = std::make_shared<Number>(v);
+        num->interned = true;
+    }
+    return num;
+}
+
+Identifier::Identifier(Symbol s) : value{s}, version{} {};
+Identifier::Identifier(Symbol s, const uint32_t & ver) : value{s}, version{ver} {};
 
 bool Identifier::is_reduced() const { return false; }
 
 std::string Identifier::print() const {
-    return "Identifier { value = " + value + "; version = " + to_string(version) + " }";
+    return "Identifier { value = " + value.str() + "; version = " + to_string(version) + " }";
 }
 
 Array::Array(std::vector<Object> && a) : value{std::move(a)} {};
 
 bool Array::is_reduced() const {
-    return std::all_of(value.begin(), value.end(), [](const Object & obj) {
-        return std::visit([](auto && o) { return o->is_reduced(); }, obj);
-    });
+    if (!reduced) {
+        reduced = std::all_of(value.begin(), value.end(), [](const Object & obj) {
+            return std::visit([](auto && o) { return o->is_reduced(); }, obj);
+        });
+    }
+    return reduced;
 }
 
 std::string Array::print() const { return "Array { value = " + to_string(value) + " }"; }
 
 bool Dict::is_reduced() const {
-    return std::all_of(value.begin(), value.end(), [](auto && pair) {
-        // TODO: need to handle key being an Object
-        auto && [_, v] = pair;
-        return std::visit([](auto && o) { return o->is_reduced(); }, v);
-    });
+    if (!reduced) {
+        reduced = std::all_of(value.begin(), value.end(), [](auto && pair) {
+            // TODO: need to handle key being an Object
+            auto && [_, v] = pair;
+            return std::visit([](auto && o) { return o->is_reduced(); }, v);
+        });
+    }
+    return reduced;
 }
 
 std::string Dict::print() const { return "Dict { value = " + to_string(value) + " }"; }
@@ -453,6 +681,7 @@ bool Meson::is_reduced() const { return true; }
 void link_nodes(std::shared_ptr<CFGNode> predecessor, std::shared_ptr<CFGNode> successor) {
     successor->predecessors.emplace(predecessor);
     predecessor->successors.emplace(successor);
+    ++cfg_edits;
 }
 
 void unlink_nodes(std::shared_ptr<CFGNode> predecessor, std::shared_ptr<CFGNode> successor,
@@ -471,8 +700,11 @@ void unlink_nodes(std::shared_ptr<CFGNode> predecessor, std::shared_ptr<CFGNode>
 
     successor->predecessors.erase(predecessor);
     predecessor->successors.erase(successor);
+    ++cfg_edits;
 }
 
+uint64_t cfg_epoch() { return cfg_edits; }
+
 void set_var(const Object & src, Object & dest) {
     const Variable & var = std::visit(VariableGetter{}, src);
     std::visit(VariableSetter{var}, dest);
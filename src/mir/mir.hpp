@@ -13,22 +13,74 @@
 
 #include <cstdint>
 #include <filesystem>
-#include <list>
+#include <functional>
+#include <iosfwd>
 #include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <sys/types.h>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 
+#include "flat_map.hpp"
 #include "toolchains/toolchain.hpp"
 
 namespace fs = std::filesystem;
 
 namespace MIR {
 
+/**
+ * An interned name
+ *
+ * The names of variables and identifiers are interned in a global table, so
+ * that comparing or hashing them is an integer operation instead of a string
+ * one. Each distinct name has a small, dense id, which can be used to index
+ * arrays.
+ *
+ * The empty name is the default Symbol, and has id 0.
+ */
+class Symbol {
+  public:
+    Symbol() = default;
+    Symbol(std::string_view);
+    Symbol(const std::string & s) : Symbol{std::string_view{s}} {};
+    Symbol(const char * s) : Symbol{std::string_view{s}} {};
+
+    /// The name this symbol was interned from
+    const std::string & str() const;
+
+    /// The unique id of this Symbol
+    uint32_t id() const;
+
+    bool empty() const { return entry == nullptr; }
+
+    operator const std::string &() const { return str(); }
+
+    bool operator==(const Symbol & o) const { return entry == o.entry; }
+    bool operator!=(const Symbol & o) const { return entry != o.entry; }
+    bool operator<(const Symbol & o) const { return id() < o.id(); }
+
+    bool operator==(std::string_view o) const { return str() == o; }
+    bool operator!=(std::string_view o) const { return str() != o; }
+    bool operator==(const std::string & o) const { return str() == o; }
+    bool operator!=(const std::string & o) const { return str() != o; }
+    bool operator==(const char * o) const { return str() == o; }
+    bool operator!=(const char * o) const { return str() != o; }
+
+    /// The number of Symbols that have been interned, all ids are less than this
+    static uint32_t count();
+
+    struct Entry;
+
+  private:
+    const Entry * entry = nullptr;
+};
+
+std::ostream & operator<<(std::ostream &, const Symbol &);
+
 /**
  * Information about an object when it is stored to a variable
  *
@@ -41,12 +93,12 @@ namespace MIR {
 class Variable {
   public:
     Variable();
-    Variable(std::string n);
-    Variable(std::string n, const uint32_t & v);
+    Variable(Symbol n);
+    Variable(Symbol n, const uint32_t & v);
     Variable(const Variable & v) = default;
     Variable & operator=(const Variable & v) = default;
 
-    std::string name;
+    Symbol name;
 
     /// The version as used by value numbering, 0 means unset
     uint32_t gvn;
@@ -54,6 +106,7 @@ class Variable {
     explicit operator bool() const;
     bool operator<(const Variable &) const;
     bool operator==(const Variable &) const;
+    bool operator!=(const Variable &) const;
 
     // Print a human readable version of this Variable
     std::string print() const;
@@ -118,13 +171,49 @@ using Object =
 
 using Callable = std::variant<FilePtr, ExecutablePtr, ProgramPtr>;
 
+/// Storage for keyword arguments and dictionaries, sorted by key
+using ObjectMap = Util::FlatMap<Object>;
+
+/**
+ * A directory of the project, shared by all of the Files in it
+ *
+ * A project may have tens of thousands of Files, but only a handful of
+ * directories. Rather than each File holding its own copy of the source and
+ * build roots, they share an interned Directory, which also gives the paths
+ * between the source and build versions of the directory. The paths are
+ * interned and converted with Util::Paths, so each is stored once.
+ */
+class Directory {
+  public:
+    Directory(const fs::path & sdir, const fs::path & sr_, const fs::path & br_);
+
+    /// Get the shared Directory for a subdir of the given roots
+    static std::shared_ptr<const Directory> intern(const fs::path & subdir,
+                                                   const fs::path & source_root,
+                                                   const fs::path & build_root);
+
+    const fs::path & subdir;
+    const fs::path & source_root;
+    const fs::path & build_root;
+
+    /// The source directory, relative to the build directory
+    const fs::path & source_from_build;
+
+    /// The build directory, relative to the source directory
+    const fs::path & build_from_source;
+};
+
+using DirectoryPtr = std::shared_ptr<const Directory>;
+
 /**
  * Holds a File, which is a smart object point to a source
  *
  */
 class File {
   public:
-    File(std::string name_, fs::path sdir, const bool & built_, fs::path sr_, fs::path br_);
+    File(std::string name_, DirectoryPtr dir, const bool & built_);
+    File(std::string name_, const fs::path & sdir, const bool & built_, const fs::path & sr_,
+         const fs::path & br_);
 
     /// Whether this is a built object, or a static one
     bool is_built() const;
@@ -134,10 +223,10 @@ class File {
     std::string get_name() const;
 
     /// Get a path for this file relative to the source tree
-    fs::path relative_to_source_dir() const;
+    const fs::path & relative_to_source_dir() const;
 
-    /// Get a path for this file relative to the build treeZ
-    fs::path relative_to_build_dir() const;
+    /// Get a path for this file relative to the build tree
+    const fs::path & relative_to_build_dir() const;
 
     bool operator==(const File &) const;
     bool operator!=(const File &) const;
@@ -152,12 +241,15 @@ class File {
     friend std::ostream & operator<<(std::ostream & os, const File & f);
 
     const std::string name;
-    const fs::path subdir;
+    const DirectoryPtr directory;
     const bool built;
-    const fs::path source_root;
-    const fs::path build_root;
 
     Variable var;
+
+  private:
+    /// Calculated once, as the backend asks for these many times
+    const fs::path source_relative;
+    const fs::path build_relative;
 };
 
 class CustomTarget {
@@ -437,21 +529,76 @@ class Compiler {
     Variable var;
 };
 
+/**
+ * The functions and methods that the lowering passes handle
+ *
+ * The name of a FunctionCall is resolved to one of these once, when the call is
+ * created, so that passes can dispatch on it, and skip calls that are not
+ * theirs, without comparing strings. Methods share the id of any other function
+ * or method with the same name.
+ */
+enum class Builtin : uint8_t {
+    UNKNOWN,
+    ADD_GLOBAL_ARGUMENTS,
+    ADD_GLOBAL_LINK_ARGUMENTS,
+    ADD_PROJECT_ARGUMENTS,
+    ADD_PROJECT_LINK_ARGUMENTS,
+    ASSERT,
+    CPU,
+    CPU_FAMILY,
+    CUSTOM_TARGET,
+    DECLARE_DEPENDENCY,
+    DEPENDENCY,
+    DISABLER,
+    ENDIAN,
+    ERROR,
+    EXECUTABLE,
+    FILES,
+    FIND_PROGRAM,
+    FOUND,
+    GET_COMPILER,
+    GET_ID,
+    INCLUDE_DIRECTORIES,
+    MESSAGE,
+    NAME,
+    PROJECT,
+    REL_EQ,
+    REL_NE,
+    STATIC_LIBRARY,
+    SYSTEM,
+    TEST,
+    UNARY_NEG,
+    UNARY_NOT,
+    VCS_TAG,
+    VERSION,
+    VERSION_COMPARE,
+    WARNING,
+};
+
+/// The number of Builtins, for tables indexed by them
+constexpr size_t builtin_count = static_cast<size_t>(Builtin::WARNING) + 1;
+
+/// Find the Builtin for a function or method name, or Builtin::UNKNOWN
+Builtin builtin_id(std::string_view name);
+
 // Can be a method via an optional paramter maybe?
 /// A function call object
 class FunctionCall {
   public:
     FunctionCall(std::string _name, std::vector<Object> && _pos,
-                 std::unordered_map<std::string, Object> && _kw, std::filesystem::path _sd);
+                 ObjectMap && _kw, std::filesystem::path _sd);
     FunctionCall(std::string _name, std::vector<Object> && _pos, std::filesystem::path _sd);
 
     const std::string name;
 
+    /// The builtin that name refers to
+    const Builtin id;
+
     /// Ordered container of positional argument objects
     std::vector<Object> pos_args;
 
-    /// Unordered container mapping keyword arguments to their values
-    std::unordered_map<std::string, Object> kw_args;
+    /// Container mapping keyword arguments to their values, sorted by name
+    ObjectMap kw_args;
 
     /// reference to object holding this function, it's monostate if not
     std::optional<Object> holder;
@@ -470,7 +617,21 @@ class FunctionCall {
     /// Is this a fully reduced object?
     bool is_reduced() const;
 
+    /**
+     * Are all of the positional and keyword arguments fully reduced?
+     *
+     * Once they are this is remembered, so the lowering passes can check it
+     * cheaply on every walk.
+     */
+    bool args_reduced() const;
+
+    /// Forget that the arguments were reduced, for when one of them has been replaced
+    void changed() const { reduced = false; }
+
     Variable var;
+
+  private:
+    mutable bool reduced = false;
 };
 
 class Disabler {
@@ -490,6 +651,18 @@ class String {
   public:
     String(std::string f);
 
+    /**
+     * Get the shared node for a constant string
+     *
+     * Identical constants share one node, so comparing them is usually just a
+     * pointer comparison. Shared nodes are never modified, VariableSetter
+     * assigns a variable to a copy of them instead.
+     */
+    static StringPtr intern(std::string_view);
+
+    /// Is this a shared node from intern()?
+    bool is_interned() const { return interned; }
+
     bool operator==(const String &) const;
     bool operator!=(const String &) const;
 
@@ -502,12 +675,21 @@ class String {
     bool is_reduced() const;
 
     Variable var;
+
+  private:
+    bool interned = false;
 };
 
 class Boolean {
   public:
     Boolean(const bool & f);
 
+    /// Get the shared node for a constant boolean, as String::intern() does
+    static BooleanPtr intern(bool);
+
+    /// Is this a shared node from intern()?
+    bool is_interned() const { return interned; }
+
     bool operator==(const Boolean &) const;
     bool operator!=(const Boolean &) const;
 
@@ -520,12 +702,21 @@ class Boolean {
     bool is_reduced() const;
 
     Variable var;
+
+  private:
+    bool interned = false;
 };
 
 class Number {
   public:
     Number(const int64_t & f);
 
+    /// Get the shared node for a constant number, as String::intern() does
+    static NumberPtr intern(int64_t);
+
+    /// Is this a shared node from intern()?
+    bool is_interned() const { return interned; }
+
     bool operator==(const Number &) const;
     bool operator!=(const Number &) const;
 
@@ -538,15 +729,18 @@ class Number {
     bool is_reduced() const;
 
     Variable var;
+
+  private:
+    bool interned = false;
 };
 
 class Identifier {
   public:
-    Identifier(std::string s);
-    Identifier(std::string s, const uint32_t & ver);
+    Identifier(Symbol s);
+    Identifier(Symbol s, const uint32_t & ver);
 
     /// The name of the identifier
-    const std::string value;
+    const Symbol value;
 
     /**
      * The Value numbering version
@@ -584,10 +778,16 @@ class Array {
     /// Print a human readable version of this
     std::string print() const;
 
-    /// Is this a fully reduced object?
+    /// Is this a fully reduced object? Remembered as FunctionCall::args_reduced() is
     bool is_reduced() const;
 
+    /// Forget that the values were reduced, as FunctionCall::changed() does
+    void changed() const { reduced = false; }
+
     Variable var;
+
+  private:
+    mutable bool reduced = false;
 };
 
 class Dict {
@@ -596,15 +796,21 @@ class Dict {
 
     // TODO: the key is allowed to be a string or an expression that evaluates
     // to a string, we need to enforce that somewhere.
-    std::unordered_map<std::string, Object> value;
+    ObjectMap value;
 
     /// Print a human readable version of this
     std::string print() const;
 
-    /// Is this a fully reduced object?
+    /// Is this a fully reduced object? Remembered as FunctionCall::args_reduced() is
     bool is_reduced() const;
 
+    /// Forget that the values were reduced, as FunctionCall::changed() does
+    void changed() const { reduced = false; }
+
     Variable var;
+
+  private:
+    mutable bool reduced = false;
 };
 
 class AddArguments {
@@ -681,8 +887,15 @@ class BasicBlock {
   public:
     BasicBlock() = default;
 
-    /// The instructions in this block
-    std::list<Object> instructions;
+    /**
+     * The instructions in this block
+     *
+     * These are stored contiguously, as every pass walks them repeatedly.
+     * Replacing an instruction is an assignment, but inserting or erasing
+     * invalidates iterators and references to the instructions after that
+     * point.
+     */
+    std::vector<Object> instructions;
 
     Variable var;
 };
@@ -753,7 +966,12 @@ struct VariableSetter {
 
     void operator()(AddArgumentsPtr & o) const { o->var = var; }
     void operator()(ArrayPtr & o) const { o->var = var; }
-    void operator()(BooleanPtr & o) const { o->var = var; }
+    void operator()(BooleanPtr & o) const {
+        if (o->is_interned()) {
+            o = std::make_shared<Boolean>(o->value);
+        }
+        o->var = var;
+    }
     void operator()(BranchPtr & o) const { o->var = var; }
     void operator()(CompilerPtr & o) const { o->var = var; }
     void operator()(CustomTargetPtr & o) const { o->var = var; }
@@ -767,11 +985,21 @@ struct VariableSetter {
     void operator()(IncludeDirectoriesPtr & o) const { o->var = var; }
     void operator()(JumpPtr & o) const { o->var = var; }
     void operator()(MessagePtr & o) const { o->var = var; }
-    void operator()(NumberPtr & o) const { o->var = var; }
+    void operator()(NumberPtr & o) const {
+        if (o->is_interned()) {
+            o = std::make_shared<Number>(o->value);
+        }
+        o->var = var;
+    }
     void operator()(PhiPtr & o) const { o->var = var; }
     void operator()(ProgramPtr & o) const { o->var = var; }
     void operator()(StaticLibraryPtr & o) const { o->var = var; }
-    void operator()(StringPtr & o) const { o->var = var; }
+    void operator()(StringPtr & o) const {
+        if (o->is_interned()) {
+            o = std::make_shared<String>(o->value);
+        }
+        o->var = var;
+    }
     void operator()(TestPtr & o) const { o->var = var; }
     void operator()(MesonPtr & o) const { o->var = var; }
 };
@@ -782,4 +1010,28 @@ void link_nodes(std::shared_ptr<CFGNode> predecessor, std::shared_ptr<CFGNode> s
 void unlink_nodes(std::shared_ptr<CFGNode> predecessor, std::shared_ptr<CFGNode> successor,
                   bool recursive = true);
 
+/**
+ * The number of edges added or removed by link_nodes and unlink_nodes
+ *
+ * Analyses of the shape of the graph are valid until this changes.
+ */
+uint64_t cfg_epoch();
+
 } // namespace MIR
+
+namespace std {
+
+template <> struct hash<MIR::Symbol> {
+    size_t operator()(const MIR::Symbol & s) const noexcept { return s.id(); }
+};
+
+template <> struct hash<MIR::Variable> {
+    size_t operator()(const MIR::Variable & v) const noexcept {
+        // Combined as boost::hash_combine does, which works for any width of size_t
+        size_t seed = hash<MIR::Symbol>{}(v.name);
+        seed ^= hash<uint32_t>{}(v.gvn) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
+
+} // namespace std
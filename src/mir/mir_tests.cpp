@@ -67,6 +67,17 @@ TEST(file, not_equal) {
     ASSERT_NE(f, i);
 }
 
+TEST(file, shared_directory) {
+    MIR::File f{"foo.c", "sub", false, "/home/user/src", "/home/user/src/build"};
+    MIR::File g{"bar.c", "sub", true, "/home/user/src", "/home/user/src/build"};
+    EXPECT_EQ(f.directory, g.directory);
+    EXPECT_EQ(f.directory->source_from_build, "../../sub");
+    EXPECT_EQ(f.directory->build_from_source, "../build/sub");
+
+    MIR::File h{"foo.c", "sub2", false, "/home/user/src", "/home/user/src/build"};
+    EXPECT_NE(f.directory, h.directory);
+}
+
 TEST(number, equal) {
     MIR::Number two{2};
     MIR::Number two_2{2};
@@ -80,3 +91,60 @@ TEST(number, not_equal) {
 
     ASSERT_NE(two, one);
 }
+
+TEST(symbol, interned) {
+    const MIR::Symbol a{"symbol_interned_a"};
+    const MIR::Symbol b{std::string{"symbol_interned_b"}};
+    const MIR::Symbol a2{std::string{"symbol_interned_a"}};
+
+    ASSERT_EQ(a, a2);
+    ASSERT_EQ(a.id(), a2.id());
+    ASSERT_NE(a, b);
+    ASSERT_NE(a.id(), b.id());
+    ASSERT_EQ(a.str(), "symbol_interned_a");
+    ASSERT_EQ(b, "symbol_interned_b");
+    ASSERT_LT(a.id(), MIR::Symbol::count());
+}
+
+TEST(symbol, empty) {
+    const MIR::Symbol e{};
+    ASSERT_TRUE(e.empty());
+    ASSERT_EQ(e.id(), 0);
+    ASSERT_EQ(e, MIR::Symbol{""});
+    ASSERT_EQ(e.str(), "");
+    ASSERT_FALSE(MIR::Variable{});
+}
+
+TEST(constants, interned) {
+    const auto a = MIR::String::intern("constants_interned");
+    const auto b = MIR::String::intern(std::string{"constants_interned"});
+    ASSERT_EQ(a, b);
+    ASSERT_TRUE(a->is_interned());
+    ASSERT_NE(MIR::String::intern("constants_other"), a);
+
+    ASSERT_EQ(MIR::Number::intern(42), MIR::Number::intern(42));
+    ASSERT_NE(MIR::Number::intern(42), MIR::Number::intern(43));
+    ASSERT_EQ(MIR::Boolean::intern(true), MIR::Boolean::intern(true));
+    ASSERT_FALSE(MIR::Boolean::intern(false)->value);
+
+    // The nodes are never directly assigned to a variable
+    MIR::Object obj = a;
+    std::visit(MIR::VariableSetter{MIR::Variable{"x"}}, obj);
+    ASSERT_NE(std::get<MIR::StringPtr>(obj), a);
+    ASSERT_FALSE(std::get<MIR::StringPtr>(obj)->is_interned());
+    ASSERT_EQ(std::get<MIR::StringPtr>(obj)->value, "constants_interned");
+    ASSERT_EQ(std::get<MIR::StringPtr>(obj)->var.name, "x");
+    ASSERT_FALSE(a->var);
+}
+
+TEST(builtin, ids) {
+    ASSERT_EQ(MIR::builtin_id("add_global_arguments"), MIR::Builtin::ADD_GLOBAL_ARGUMENTS);
+    ASSERT_EQ(MIR::builtin_id("warning"), MIR::Builtin::WARNING);
+    ASSERT_EQ(MIR::builtin_id("version"), MIR::Builtin::VERSION);
+    ASSERT_EQ(MIR::builtin_id("version_compare"), MIR::Builtin::VERSION_COMPARE);
+    ASSERT_EQ(MIR::builtin_id("not_a_function"), MIR::Builtin::UNKNOWN);
+    ASSERT_EQ(MIR::builtin_id(""), MIR::Builtin::UNKNOWN);
+
+    const MIR::FunctionCall f{"find_program", {}, ""};
+    ASSERT_EQ(f.id, MIR::Builtin::FIND_PROGRAM);
+}
@@ -12,8 +12,14 @@
 #include "state/state.hpp"
 #include "toolchains/toolchain.hpp"
 
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace MIR::Passes {
 
@@ -24,7 +30,7 @@ namespace MIR::Passes {
  * to trim away dead branches and join the ir lists together so we end up with a
  * single flat list of Objects.
  */
-bool branch_pruning(std::shared_ptr<CFGNode>);
+bool branch_pruning(const std::shared_ptr<CFGNode> &);
 
 /**
  * Join basic blocks together
@@ -32,7 +38,7 @@ bool branch_pruning(std::shared_ptr<CFGNode>);
  * Specifically for use after branch_pruning, when we have two continguous
  * blocks with no condition to move between thme
  */
-bool join_blocks(std::shared_ptr<CFGNode>);
+bool join_blocks(const std::shared_ptr<CFGNode> &);
 
 /**
  * Lower away machine related information.
@@ -87,40 +93,131 @@ std::optional<Object> lower_free_functions(const Object &, const State::Persista
  */
 std::optional<Object> flatten(const Object &);
 
+/**
+ * The dominator tree and dominance frontiers of the blocks reachable from a root
+ *
+ * This is a snapshot, it must be recalculated if the shape of the graph changes.
+ */
+struct DominatorTree {
+    DominatorTree(const std::shared_ptr<CFGNode> & root);
+
+    /// The reachable blocks, in the order graph_walker visits them
+    std::vector<std::shared_ptr<CFGNode>> order;
+
+    /// The immediate dominator of each block, the root is its own dominator
+    std::unordered_map<uint32_t, uint32_t> idom;
+
+    /// The dominance frontier of each block that has a non-empty one
+    std::unordered_map<uint32_t, std::vector<uint32_t>> frontier;
+};
+
+/**
+ * Put the program into SSA form
+ *
+ * Phis are placed at the iterated dominance frontiers of each variable's
+ * definitions (Cytron et al.), then variables are numbered as each block is
+ * walked.
+ */
 struct GlobalValueNumbering {
-    bool operator()(std::shared_ptr<CFGNode>);
+    bool operator()(const std::shared_ptr<CFGNode> &);
 
   private:
-    std::unordered_map<uint32_t, std::unordered_map<std::string, uint32_t>> data;
-    std::unordered_map<std::string, uint32_t> gvn;
+    /// The versions of variables defined in each block, including by phis
+    std::unordered_map<uint32_t, std::unordered_map<Symbol, uint32_t>> data;
+
+    /// The variables that may need a phi at the start of each block
+    std::unordered_map<uint32_t, std::vector<Symbol>> phis;
+
+    /// Calculated when the first (root) block is walked
+    std::optional<DominatorTree> dominators;
+
+    /// The last version handed out for each variable, indexed by Symbol id
+    std::vector<uint32_t> gvn;
+
+    void place_phis();
+    uint32_t lookup(const Symbol &, uint32_t) const;
+    uint32_t next_version(const Symbol &);
     bool number(Object &, const uint32_t);
     bool insert_phis(CFGNode &);
 };
 
-bool fixup_phis(std::shared_ptr<CFGNode>);
+/**
+ * Replace repeated calls to pure functions with the result of the first call
+ *
+ * A call to a function without side effects, such as `find_program()` or
+ * `include_directories()`, with the same arguments as an earlier call that was
+ * assigned to a variable and dominates it is replaced by a reference to that
+ * variable, so only the first call is lowered.
+ *
+ * This must be run after GlobalValueNumbering, as arguments are compared by
+ * their variable versions.
+ */
+struct CommonSubexpressions {
+    bool operator()(const std::shared_ptr<CFGNode> &);
+
+  private:
+    struct Entry {
+        Variable var;
+        uint32_t block;
+    };
+
+    /// The assigned calls seen so far, by a key of the name and arguments
+    std::unordered_map<std::string, std::vector<Entry>> calls;
 
+    /// Calculated when the first (root) block is walked
+    std::optional<DominatorTree> dominators;
+
+    std::unordered_set<uint32_t> walked;
+
+    bool dominates(uint32_t, uint32_t) const;
+    const Entry * find(const std::string &, uint32_t) const;
+};
+
+bool fixup_phis(const std::shared_ptr<CFGNode> &);
+
+/**
+ * Replace uses of aliases (`y₁ = x₁`) with the variable they alias
+ */
 struct ConstantFolding {
-    bool operator()(std::shared_ptr<CFGNode>);
+    bool operator()(const std::shared_ptr<CFGNode> &);
 
   private:
-    std::map<Variable, Variable> data;
+    /// Union-find forest of aliases, mapping each alias to the variable it was assigned from
+    std::unordered_map<Variable, Variable> data;
+
+    /// Find the variable at the root of an alias chain, compressing the path to it
+    Variable find(const Variable &);
     std::optional<Object> impl(const Object &);
 };
 
 /**
  * push variables out of assignments into their uses
+ *
+ * This keeps def-use chains between walks: the definition of each variable
+ * that can be propagated, and for each variable that cannot be (yet), where
+ * it is used. When a variable gets a propagatable definition its pending uses
+ * are rewritten straight away.
  */
 struct ConstantPropagation {
-    bool operator()(std::shared_ptr<CFGNode>);
+    bool operator()(const std::shared_ptr<CFGNode> &);
 
   private:
-    std::map<Variable, Object *> data;
-    bool update_data(Object &);
+    /// Where a use is, by CFGNode::index and the position of the instruction in the block
+    using Position = std::pair<uint32_t, size_t>;
+
+    /// Definitions of the variables that can be propagated
+    std::unordered_map<Variable, Object> data;
+
+    /// Uses of variables that do not have a propagatable definition
+    std::unordered_map<Variable, std::map<Position, std::weak_ptr<CFGNode>>> pending;
+
+    bool define(const Object &);
+    bool propagate(const std::shared_ptr<CFGNode> &, size_t index);
     std::optional<Object> get(const IdentifierPtr & id) const;
-    std::optional<Object> impl(const Object & obj) const;
-    bool impl(Object & obj) const;
 };
 
+class PassTimer;
+
 /**
  * Do work that can be more optimally handled in threads.
  *
@@ -132,6 +229,7 @@ struct ConstantPropagation {
  * These can be done in parallel, using the cache
  */
 bool threaded_lowering(std::shared_ptr<CFGNode>, State::Persistant & pstate);
+bool threaded_lowering(std::shared_ptr<CFGNode>, State::Persistant & pstate, PassTimer & timer);
 
 /**
  * Lower Program objects and their methods
@@ -151,7 +249,7 @@ std::optional<Object> lower_dependency_objects(const Object & inst,
 std::optional<Object> lower_compiler_methods(const Object & inst);
 
 /// Delete any code that has become unreachable
-bool delete_unreachable(std::shared_ptr<CFGNode> block);
+bool delete_unreachable(const std::shared_ptr<CFGNode> & block);
 
 /// @brief If an object holds a disabler, disable it
 /// @param obj the object to check
@@ -165,7 +263,7 @@ class Printer {
   public:
     Printer(uint32_t p = 0);
     ~Printer();
-    bool operator()(const std::shared_ptr<CFGNode>);
+    bool operator()(const std::shared_ptr<CFGNode> &);
     void increment();
     uint32_t pass;
 
@@ -173,9 +271,61 @@ class Printer {
     std::ofstream out{};
 };
 
+/// Debugging helper that records how long each pass takes, and how much work
+/// it does, and prints a summary when destroyed.
+/// controlled by setting the MESONPP_TIME_PASSES environment variable
+class PassTimer {
+  public:
+    using BlockPass = std::function<bool(const std::shared_ptr<CFGNode> &)>;
+    using Clock = std::chrono::steady_clock;
+
+    PassTimer();
+    explicit PassTimer(bool enabled_);
+    ~PassTimer();
+
+    /// Wrap a block pass so that each call to it is recorded under the given name
+    BlockPass wrap(std::string name, BlockPass pass);
+
+    /// Start a new iteration of the given phase, all work is recorded against
+    /// it until the next call
+    void iteration(std::string phase);
+
+    /// Records the time between its creation and destruction as one call of a pass
+    class Scope {
+      public:
+        Scope(PassTimer &, std::string);
+        ~Scope();
+
+      private:
+        PassTimer & timer;
+        const size_t index;
+        const Clock::time_point start;
+    };
+
+    const bool enabled;
+
+  private:
+    struct Stats {
+        std::string name;
+        Clock::duration time{};
+        uint64_t calls = 0;
+        uint64_t instructions = 0;
+        uint64_t progress = 0;
+    };
+
+    /// Per pass totals, in the order the passes were first seen
+    std::vector<Stats> passes;
+
+    /// Totals for each iteration, with the phase name in place of the pass name
+    std::vector<Stats> iterations;
+
+    size_t find(std::string);
+    void record(size_t, Clock::duration, uint64_t, bool);
+};
+
 /// @brief Move AddArgument nodes to the top of the program
 /// @param block The block to operate on
 /// @return true if any work is done, otherwise false
-bool combine_add_arguments(std::shared_ptr<CFGNode> block);
+bool combine_add_arguments(const std::shared_ptr<CFGNode> & block);
 
 } // namespace MIR::Passes
@@ -10,8 +10,14 @@
 #include "exceptions.hpp"
 #include "mir.hpp"
 
+#include <cstddef>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <variant>
+#include <vector>
 
 namespace MIR::Passes {
 
@@ -118,8 +124,8 @@ std::vector<T> extract_variadic_arguments(std::vector<Object>::const_iterator st
 /// @param err_msg The message to throw if the argument is of the incorrect type
 /// @return the value associated with that name
 template <typename T>
-std::optional<T> extract_keyword_argument(const std::unordered_map<std::string, Object> & kwargs,
-                                          const std::string & name, const std::string & err_msg) {
+std::optional<T> extract_keyword_argument(const ObjectMap & kwargs, std::string_view name,
+                                          const std::string & err_msg) {
     const auto & found = kwargs.find(name);
     if (found == kwargs.end()) {
         return std::nullopt;
@@ -135,8 +141,7 @@ std::optional<T> extract_keyword_argument(const std::unordered_map<std::string,
 /// @return the value associated with that name
 template <typename T, typename... Args>
 std::variant<std::monostate, T, Args...>
-extract_keyword_argument_v(const std::unordered_map<std::string, Object> & kwargs,
-                           const std::string & name) {
+extract_keyword_argument_v(const ObjectMap & kwargs, std::string_view name) {
     // FIXME: this has the same problem as the other version, which is that you
     // can't distinguish between "not present" and "not a valid type"
     const auto & found = kwargs.find(name);
@@ -154,8 +159,8 @@ extract_keyword_argument_v(const std::unordered_map<std::string, Object> & kwarg
 /// @return the value associated with that name
 template <typename T>
 std::optional<std::vector<T>>
-extract_keyword_argument_a(const std::unordered_map<std::string, Object> & kwargs,
-                           const std::string & name, const std::string & err_msg) {
+extract_keyword_argument_a(const ObjectMap & kwargs, std::string_view name,
+                           const std::string & err_msg) {
     auto found = kwargs.find(name);
     if (found == kwargs.end()) {
         return std::nullopt;
@@ -182,8 +187,8 @@ extract_keyword_argument_a(const std::unordered_map<std::string, Object> & kwarg
 /// @return the value associated with that name
 template <typename... Args>
 std::optional<std::vector<std::variant<Args...>>>
-extract_keyword_argument_av(const std::unordered_map<std::string, Object> & kwargs,
-                            const std::string & name, const std::string & err_msg) {
+extract_keyword_argument_av(const ObjectMap & kwargs, std::string_view name,
+                            const std::string & err_msg) {
     const auto & found = kwargs.find(name);
     if (found == kwargs.end()) {
         return std::nullopt;
@@ -201,4 +206,281 @@ extract_keyword_argument_av(const std::unordered_map<std::string, Object> & kwar
         extract_positional_argument_v<Args...>(found->second, err_msg)};
 }
 
+/// The remaining positional arguments, with arrays flattened, each of which must be a T
+template <typename T> struct Variadic {
+    using type = std::vector<T>;
+
+    /// How many arguments must be passed for it, counted before flattening
+    size_t min = 0;
+};
+
+/// A positional argument that must be a T
+template <typename T> struct Positional {
+    using type = T;
+};
+
+/// A positional argument that, if it is passed, must be a T
+template <typename T> struct OptionalPositional {
+    using type = std::optional<T>;
+};
+
+/// A keyword argument that must be a T
+template <typename T> struct Keyword {
+    using type = std::optional<T>;
+    std::string_view name;
+    bool required = false;
+};
+
+/// A keyword argument that must be a T or an array of T, it is empty when not passed
+template <typename T> struct KeywordList {
+    using type = std::vector<T>;
+    std::string_view name;
+    bool required = false;
+};
+
+namespace detail {
+
+/// How an argument of a given type is described in error messages
+template <typename T> inline constexpr std::string_view type_name{};
+template <> inline constexpr std::string_view type_name<StringPtr>{"a string"};
+template <> inline constexpr std::string_view type_name<BooleanPtr>{"a boolean"};
+template <> inline constexpr std::string_view type_name<NumberPtr>{"a number"};
+template <> inline constexpr std::string_view type_name<FilePtr>{"a file"};
+template <> inline constexpr std::string_view type_name<ExecutablePtr>{"an executable"};
+template <> inline constexpr std::string_view type_name<StaticLibraryPtr>{"a static_library"};
+template <> inline constexpr std::string_view type_name<IncludeDirectoriesPtr>{
+    "an include_directories object"};
+template <> inline constexpr std::string_view type_name<DependencyPtr>{"a dependency"};
+template <> inline constexpr std::string_view type_name<ProgramPtr>{"a find_program object"};
+template <> inline constexpr std::string_view type_name<CustomTargetPtr>{"a custom_target"};
+
+template <typename T> struct Match {
+    static_assert(!type_name<T>.empty(), "Missing type_name for argument type");
+
+    static std::optional<T> get(const Object & obj) {
+        if (const auto * v = std::get_if<T>(&obj)) {
+            return *v;
+        }
+        return std::nullopt;
+    }
+
+    static std::string describe() { return std::string{type_name<T>}; }
+};
+
+template <typename... Ts> struct Match<std::variant<Ts...>> {
+    static std::optional<std::variant<Ts...>> get(const Object & obj) {
+        std::optional<std::variant<Ts...>> ret{};
+        ((std::holds_alternative<Ts>(obj) ? (void)ret.emplace(std::get<Ts>(obj)) : void()), ...);
+        return ret;
+    }
+
+    static std::string describe() {
+        constexpr std::string_view names[] = {type_name<Ts>...};
+        std::string ret{names[0]};
+        for (size_t i = 1; i < sizeof...(Ts); ++i) {
+            ret += i + 1 == sizeof...(Ts) ? " or " : ", ";
+            ret += names[i];
+        }
+        return ret;
+    }
+};
+
+/// Get obj as a T, what is only called to describe the argument if it is not one
+template <typename T, typename What>
+T match_or_throw(const Object & obj, const FunctionCall & f, const What & what) {
+    if (auto v = Match<T>::get(obj)) {
+        return std::move(v.value());
+    }
+    throw Util::Exceptions::InvalidArguments{f.name + ": " + what() + " must be " +
+                                             Match<T>::describe()};
+}
+
+template <typename T, typename What>
+void flatten_into(std::vector<T> & out, const Object & obj, const FunctionCall & f,
+                  const What & what) {
+    if (const auto * arr = std::get_if<ArrayPtr>(&obj)) {
+        for (const auto & o : (*arr)->value) {
+            flatten_into(out, o, f, what);
+        }
+    } else {
+        out.emplace_back(match_or_throw<T>(obj, f, what));
+    }
+}
+
+template <typename T> struct IsPositional : std::false_type {};
+template <typename T> struct IsPositional<Positional<T>> : std::true_type {};
+
+template <typename T> struct IsOptional : std::false_type {};
+template <typename T> struct IsOptional<OptionalPositional<T>> : std::true_type {};
+
+template <typename T> struct IsVariadic : std::false_type {};
+template <typename T> struct IsVariadic<Variadic<T>> : std::true_type {};
+
+/// The number of arguments a spec needs after the required and optional ones
+template <typename T> constexpr size_t variadic_min(const Variadic<T> & v) { return v.min; }
+template <typename T> constexpr size_t variadic_min(const T &) { return 0; }
+
+/// Where a positional spec has to come, keyword specs can be anywhere
+template <typename T> constexpr int positional_rank() {
+    if constexpr (IsPositional<T>::value) {
+        return 0;
+    } else if constexpr (IsOptional<T>::value) {
+        return 1;
+    } else if constexpr (IsVariadic<T>::value) {
+        return 2;
+    } else {
+        return -1;
+    }
+}
+
+/// Whether required positionals come first, then optional ones, then Variadics
+template <typename... Specs> constexpr bool positionals_ordered() {
+    const int ranks[] = {0, positional_rank<Specs>()...};
+    int last = 0;
+    for (const int r : ranks) {
+        if (r >= 0) {
+            if (r < last) {
+                return false;
+            }
+            last = r;
+        }
+    }
+    return true;
+}
+
+inline auto positional_name(size_t i) {
+    return [i] { return "positional argument " + std::to_string(i + 1); };
+}
+
+inline auto keyword_name(std::string_view name) {
+    return [name] { return "keyword argument '" + std::string{name} + "'"; };
+}
+
+template <typename T> T extract(const FunctionCall & f, const Positional<T> &, size_t & pos) {
+    const size_t i = pos++;
+    return match_or_throw<T>(f.pos_args[i], f, positional_name(i));
+}
+
+template <typename T>
+std::optional<T> extract(const FunctionCall & f, const OptionalPositional<T> &, size_t & pos) {
+    if (pos >= f.pos_args.size()) {
+        return std::nullopt;
+    }
+    const size_t i = pos++;
+    return match_or_throw<T>(f.pos_args[i], f, positional_name(i));
+}
+
+template <typename T>
+std::vector<T> extract(const FunctionCall & f, const Variadic<T> &, size_t & pos) {
+    std::vector<T> ret{};
+    for (; pos < f.pos_args.size(); ++pos) {
+        flatten_into(ret, f.pos_args[pos], f, positional_name(pos));
+    }
+    return ret;
+}
+
+inline const Object * find_keyword(const FunctionCall & f, std::string_view name,
+                                   bool required) {
+    const auto found = f.kw_args.find(name);
+    if (found != f.kw_args.end()) {
+        return &found->second;
+    }
+    if (required) {
+        throw Util::Exceptions::InvalidArguments{f.name + ": missing required keyword argument '" +
+                                                 std::string{name} + "'"};
+    }
+    return nullptr;
+}
+
+template <typename T>
+std::optional<T> extract(const FunctionCall & f, const Keyword<T> & kw, size_t &) {
+    if (const Object * obj = find_keyword(f, kw.name, kw.required)) {
+        return match_or_throw<T>(*obj, f, keyword_name(kw.name));
+    }
+    return std::nullopt;
+}
+
+template <typename T>
+std::vector<T> extract(const FunctionCall & f, const KeywordList<T> & kw, size_t &) {
+    std::vector<T> ret{};
+    if (const Object * obj = find_keyword(f, kw.name, kw.required)) {
+        flatten_into(ret, *obj, f, keyword_name(kw.name));
+    }
+    return ret;
+}
+
+} // namespace detail
+
+/**
+ * The arguments a function takes, and their types
+ *
+ * Each spec describes one argument. Positional specs are matched in order,
+ * required ones first, then optional ones, then at most one Variadic to take
+ * the rest. Keyword arguments not described by a spec are ignored.
+ *
+ *     constexpr Signature include_directories_args{
+ *         Variadic<StringPtr>{},
+ *         Keyword<BooleanPtr>{"is_system"},
+ *     };
+ *     const auto & [dirs, is_system] = include_directories_args(*f);
+ *
+ * Calling the signature checks every argument of the call, and returns a tuple
+ * with one typed value for each spec. Keyword names are views, so looking them
+ * up does not build strings, and error messages are only built when a check
+ * fails.
+ */
+template <typename... Specs> class Signature {
+  public:
+    using Result = std::tuple<typename Specs::type...>;
+
+    constexpr Signature(Specs... specs_) : specs{specs_...} {}
+
+    Result operator()(const FunctionCall & f) const {
+        check_arity(f, minimum());
+        size_t pos = 0;
+        // Arguments in a braced initializer are evaluated in order
+        return std::apply(
+            [&](const auto &... s) { return Result{detail::extract(f, s, pos)...}; }, specs);
+    }
+
+  private:
+    static constexpr size_t required = (size_t{0} + ... + detail::IsPositional<Specs>::value);
+    static constexpr size_t optional = (size_t{0} + ... + detail::IsOptional<Specs>::value);
+    static constexpr size_t variadic = (size_t{0} + ... + detail::IsVariadic<Specs>::value);
+    static_assert(variadic <= 1, "A Signature may only have one Variadic");
+    static_assert(detail::positionals_ordered<Specs...>(),
+                  "Positional specs must come before OptionalPositionals, and those before a "
+                  "Variadic");
+
+    /// The fewest positional arguments that can be passed
+    constexpr size_t minimum() const {
+        // Optional arguments are filled before the Variadic is
+        const size_t min = std::apply(
+            [](const auto &... s) { return (size_t{0} + ... + detail::variadic_min(s)); }, specs);
+        return min == 0 ? required : required + optional + min;
+    }
+
+    static void check_arity(const FunctionCall & f, size_t min) {
+        const size_t got = f.pos_args.size();
+        if (got >= min && (variadic || got <= required + optional)) {
+            return;
+        }
+
+        std::string expected;
+        if (variadic) {
+            expected = "at least " + std::to_string(min);
+        } else if (optional == 0) {
+            expected = std::to_string(required);
+        } else {
+            expected = "between " + std::to_string(required) + " and " +
+                       std::to_string(required + optional);
+        }
+        throw Util::Exceptions::InvalidArguments{f.name + ": takes " + expected +
+                                                 " positional arguments, got " +
+                                                 std::to_string(got)};
+    }
+
+    std::tuple<Specs...> specs;
+};
+
 } // namespace MIR::Passes
@@ -6,23 +6,25 @@
 
 namespace MIR::Passes {
 
-bool combine_add_arguments(std::shared_ptr<CFGNode> block) {
+bool combine_add_arguments(const std::shared_ptr<CFGNode> & block) {
     MIR::AddArgumentsPtr proj = nullptr;
     MIR::AddArgumentsPtr global = nullptr;
 
     bool progress = false;
 
-    for (auto it = block->block->instructions.begin(); it != block->block->instructions.end();
-         ++it) {
+    auto it = block->block->instructions.begin();
+    while (it != block->block->instructions.end()) {
         if (std::holds_alternative<MIR::AddArgumentsPtr>(*it)) {
             MIR::AddArgumentsPtr a = std::get<MIR::AddArgumentsPtr>(*it);
             if (a->is_global && global == nullptr) {
                 global = a;
+                ++it;
                 continue;
             } else if (!a->is_global && proj == nullptr) {
                 // TODO: project arguments can only be combined if they are from
                 // the same sub-project
                 proj = a;
+                ++it;
                 continue;
             }
 
@@ -37,8 +39,9 @@ bool combine_add_arguments(std::shared_ptr<CFGNode> block) {
                 }
                 progress = true;
             }
-            // We don't want to go over the same block twice
-            it = ++block->block->instructions.erase(it);
+            it = block->block->instructions.erase(it);
+        } else {
+            ++it;
         }
     }
 
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+#include "passes.hpp"
+#include "private.hpp"
+
+#include <string_view>
+
+namespace MIR::Passes {
+
+namespace {
+
+/**
+ * Functions without side effects, whose result depends only on their arguments
+ *
+ * The value is whether the result also depends on the directory the function
+ * was called from.
+ */
+const std::unordered_map<Builtin, bool> pure_functions{
+    {Builtin::FILES, true},
+    {Builtin::FIND_PROGRAM, false},
+    {Builtin::INCLUDE_DIRECTORIES, true},
+};
+
+bool write_key(std::string & key, const Object & obj);
+
+bool write_map(std::string & key, const ObjectMap & map) {
+    // ObjectMap is sorted, so equal maps are always written in the same order
+    key += '{';
+    for (const auto & [k, v] : map) {
+        key += k;
+        key += ':';
+        if (!write_key(key, v)) {
+            return false;
+        }
+    }
+    key += '}';
+    return true;
+}
+
+/**
+ * Write a structural key for an argument to the key of a call
+ *
+ * Returns false if the argument cannot be compared structurally, in which case
+ * the call is never treated as a duplicate.
+ */
+bool write_key(std::string & key, const Object & obj) {
+    if (const auto * s = std::get_if<StringPtr>(&obj)) {
+        const std::string & v = (*s)->value;
+        key += 's' + std::to_string(v.size()) + ':' + v;
+    } else if (const auto * n = std::get_if<NumberPtr>(&obj)) {
+        key += 'n' + std::to_string((*n)->value) + ';';
+    } else if (const auto * b = std::get_if<BooleanPtr>(&obj)) {
+        key += (*b)->value ? "t" : "f";
+    } else if (const auto * i = std::get_if<IdentifierPtr>(&obj)) {
+        // In SSA form an identifier and version always refers to the same value
+        if ((*i)->version == 0) {
+            return false;
+        }
+        key += 'i' + std::to_string((*i)->value.id()) + '.' + std::to_string((*i)->version) + ';';
+    } else if (const auto * a = std::get_if<ArrayPtr>(&obj)) {
+        key += '[';
+        for (const auto & e : (*a)->value) {
+            if (!write_key(key, e)) {
+                return false;
+            }
+        }
+        key += ']';
+    } else if (const auto * d = std::get_if<DictPtr>(&obj)) {
+        return write_map(key, (*d)->value);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::string> call_key(const FunctionCall & f) {
+    if (f.holder) {
+        return std::nullopt;
+    }
+    const auto pure = pure_functions.find(f.id);
+    if (pure == pure_functions.end()) {
+        return std::nullopt;
+    }
+
+    std::string key = f.name;
+    key += '(';
+    if (pure->second) {
+        key += f.source_dir.string();
+        key += ';';
+    }
+    for (const auto & a : f.pos_args) {
+        if (!write_key(key, a)) {
+            return std::nullopt;
+        }
+    }
+    if (!write_map(key, f.kw_args)) {
+        return std::nullopt;
+    }
+    key += ')';
+    return key;
+}
+
+} // namespace
+
+bool CommonSubexpressions::dominates(uint32_t dom, uint32_t block) const {
+    while (block != dom) {
+        const auto next = dominators->idom.find(block);
+        if (next == dominators->idom.end() || next->second == block) {
+            return false;
+        }
+        block = next->second;
+    }
+    return true;
+}
+
+const CommonSubexpressions::Entry * CommonSubexpressions::find(const std::string & key,
+                                                                uint32_t block) const {
+    if (const auto found = calls.find(key); found != calls.end()) {
+        for (const Entry & e : found->second) {
+            if (dominates(e.block, block)) {
+                return &e;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool CommonSubexpressions::operator()(const std::shared_ptr<CFGNode> & block) {
+    // The first block walked is the root of the graph
+    if (!dominators) {
+        dominators.emplace(block);
+    }
+
+    // Don't run this pass on the same block twice, or the first call would be
+    // found as a duplicate of itself
+    if (!walked.emplace(block->index).second) {
+        return false;
+    }
+
+    const uint32_t index = block->index;
+    const auto & replace = [&](const Object & obj) -> std::optional<Object> {
+        const auto & f = std::get<FunctionCallPtr>(obj);
+        const auto & key = call_key(*f);
+        if (!key) {
+            return std::nullopt;
+        }
+        const Entry * e = find(key.value(), index);
+        if (!e) {
+            return std::nullopt;
+        }
+        Object id = std::make_shared<Identifier>(e->var.name, e->var.gvn);
+        set_var(obj, id);
+        return id;
+    };
+
+    bool progress = false;
+    for (auto & inst : block->block->instructions) {
+        progress |= instruction_walker(inst, {}, {{replace, object_mask<FunctionCallPtr>()}});
+
+        // Only calls that are assigned can be referred to later
+        if (const auto * f = std::get_if<FunctionCallPtr>(&inst)) {
+            if (const Variable & var = (*f)->var) {
+                if (const auto & key = call_key(**f)) {
+                    calls[key.value()].emplace_back(Entry{var, index});
+                }
+            }
+        }
+    }
+
+    return progress;
+}
+
+} // namespace MIR::Passes
@@ -45,7 +45,7 @@ std::optional<Object> insert_compilers(const Object & obj, const ToolchainMap &
     }
     const auto & f = *std::get<FunctionCallPtr>(obj);
 
-    if (!(valid_holder(f.holder) && f.name == "get_compiler")) {
+    if (!(valid_holder(f.holder) && f.id == Builtin::GET_COMPILER)) {
         return std::nullopt;
     }
 
@@ -54,7 +54,7 @@ std::optional<Object> insert_compilers(const Object & obj, const ToolchainMap &
             "meson.get_compiler(): requires exactly 1 positional argument");
     }
 
-    if (!all_args_reduced(f.pos_args, f.kw_args)) {
+    if (!f.args_reduced()) {
         return std::nullopt;
     }
 
@@ -67,7 +67,7 @@ std::optional<Object> insert_compilers(const Object & obj, const ToolchainMap &
     MIR::Machines::Machine m;
     const bool native =
         extract_keyword_argument<BooleanPtr>(f.kw_args, "native", "must be a boolean")
-            .value_or(std::make_shared<Boolean>(false))
+            .value_or(Boolean::intern(false))
             ->value;
     m = native ? MIR::Machines::Machine::BUILD : MIR::Machines::Machine::HOST;
 
@@ -89,12 +89,12 @@ std::optional<Object> lower_compiler_methods(const Object & obj) {
         return std::nullopt;
     }
 
-    if (!all_args_reduced(f.pos_args, f.kw_args)) {
+    if (!f.args_reduced()) {
         return std::nullopt;
     }
 
     std::optional<Object> i;
-    if (f.name == "get_id") {
+    if (f.id == Builtin::GET_ID) {
         i.emplace(lower_get_id_method(f));
     } else {
         i = std::nullopt;
@@ -8,12 +8,23 @@
 
 namespace MIR::Passes {
 
+Variable ConstantFolding::find(const Variable & var) {
+    const auto & found = data.find(var);
+    if (found == data.end()) {
+        return var;
+    }
+    // Point the alias directly at the root, so that later lookups only take
+    // one step
+    found->second = find(found->second);
+    return found->second;
+}
+
 std::optional<Object> ConstantFolding::impl(const Object & obj) {
     if (std::holds_alternative<IdentifierPtr>(obj)) {
         const auto & id = std::get<IdentifierPtr>(obj);
         const Variable new_var{id->value, id->version};
 
-        if (const auto & found = data.find(new_var); found != data.end()) {
+        if (const Variable root = find(new_var); root != new_var) {
             /* If the id is already in the table we want to map the alias
              * directly such as:
              *
@@ -28,9 +39,9 @@ std::optional<Object> ConstantFolding::impl(const Object & obj) {
             const Variable & var = std::visit(VariableGetter{}, obj);
 
             if (var) {
-                data[var] = Variable{found->second.name, found->second.gvn};
+                data[var] = root;
             }
-            auto i = std::make_shared<Identifier>(found->second.name, found->second.gvn);
+            auto i = std::make_shared<Identifier>(root.name, root.gvn);
             i->var = var;
             return i;
         }
@@ -41,8 +52,9 @@ std::optional<Object> ConstantFolding::impl(const Object & obj) {
     return std::nullopt;
 }
 
-bool ConstantFolding::operator()(std::shared_ptr<CFGNode> block) {
-    return instruction_walker(*block, {[this](const Object & i) { return this->impl(i); }});
+bool ConstantFolding::operator()(const std::shared_ptr<CFGNode> & block) {
+    return instruction_walker(
+        *block, {{[this](const Object & i) { return this->impl(i); }, object_mask<IdentifierPtr>()}});
 };
 
 } // namespace MIR::Passes
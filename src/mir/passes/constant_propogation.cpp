@@ -9,22 +9,10 @@
 
 namespace MIR::Passes {
 
-bool ConstantPropagation::update_data(Object & obj) {
-    if (!std::holds_alternative<IdentifierPtr>(obj) && !std::holds_alternative<PhiPtr>(obj) &&
-        !std::holds_alternative<FunctionCallPtr>(obj)) {
-
-        if (auto v = std::visit(VariableGetter{}, obj)) {
-            data.emplace(v, &obj);
-        }
-    }
-
-    return false;
-}
-
 std::optional<Object> ConstantPropagation::get(const IdentifierPtr & id) const {
     const Variable var{id->value, id->version};
     if (const auto & val = data.find(var); val != data.end()) {
-        auto & obj = *val->second;
+        const auto & obj = val->second;
         if (std::holds_alternative<NumberPtr>(obj) || std::holds_alternative<StringPtr>(obj) ||
             std::holds_alternative<BooleanPtr>(obj) || std::holds_alternative<ArrayPtr>(obj) ||
             std::holds_alternative<DictPtr>(obj) || std::holds_alternative<CompilerPtr>(obj) ||
@@ -48,43 +36,73 @@ std::optional<Object> ConstantPropagation::get(const IdentifierPtr & id) const {
     return std::nullopt;
 }
 
-std::optional<Object> ConstantPropagation::impl(const Object & obj) const {
-    if (std::holds_alternative<IdentifierPtr>(obj)) {
+bool ConstantPropagation::propagate(const std::shared_ptr<CFGNode> & block, size_t index) {
+    Object & inst = block->block->instructions[index];
+    const auto & cb = [&](const Object & obj) -> std::optional<Object> {
         const auto & id = std::get<IdentifierPtr>(obj);
-        if (!std::visit(VariableGetter{}, obj)) {
-            return get(id);
+        if (std::visit(VariableGetter{}, obj)) {
+            return std::nullopt;
         }
-    }
-    return std::nullopt;
+        if (auto v = get(id)) {
+            return v;
+        }
+
+        // Remember where this use is, so that it can be rewritten as soon as
+        // the variable has a definition that can be propagated
+        pending[Variable{id->value, id->version}].insert_or_assign(Position{block->index, index},
+                                                                   block);
+        return std::nullopt;
+    };
+
+    return instruction_walker(inst, {}, {{cb, object_mask<IdentifierPtr>()}});
 }
 
-bool ConstantPropagation::impl(Object & obj) const {
-    bool progress = false;
+bool ConstantPropagation::define(const Object & inst) {
+    const Variable & v = std::visit(VariableGetter{}, inst);
+    if (!v) {
+        return false;
+    }
+
+    if (std::holds_alternative<IdentifierPtr>(inst) || std::holds_alternative<PhiPtr>(inst) ||
+        std::holds_alternative<FunctionCallPtr>(inst)) {
+        // Nothing can be done for the uses of this variable until this
+        // definition is replaced. The pass that replaces it makes progress in
+        // this block, and every block reachable from it, which includes every
+        // use, is walked again, so the uses don't need to be kept until then.
+        pending.erase(v);
+        return false;
+    }
+
+    // This is refreshed every time the block is walked, so that if the
+    // instruction is replaced the new value is used.
+    data.insert_or_assign(v, inst);
 
-    if (std::holds_alternative<FunctionCallPtr>(obj)) {
-        const auto & func = std::get<FunctionCallPtr>(obj);
-        if (func->holder && std::holds_alternative<IdentifierPtr>(func->holder.value())) {
-            if (auto v = get(std::get<IdentifierPtr>(func->holder.value()))) {
-                func->holder = v.value();
-                progress |= true;
+    // Rewrite the uses that were waiting on this definition. The instruction
+    // at a position may have been replaced since the use was found, but
+    // walking whatever is there now is still correct, as only variables with
+    // a propagatable definition are rewritten.
+    bool progress = false;
+    if (auto uses = pending.extract(v)) {
+        for (const auto & [pos, b] : uses.mapped()) {
+            const auto block = b.lock();
+            if (block && pos.second < block->block->instructions.size()) {
+                progress |= propagate(block, pos.second);
             }
         }
     }
-
     return progress;
 }
 
-bool ConstantPropagation::operator()(std::shared_ptr<CFGNode> block) {
-    // We have to break this into two walkers because we need to run this furst,
-    // then the replacement
-    bool progress =
-        instruction_walker(*block, {
-                                       [this](Object & obj) { return this->update_data(obj); },
-                                   });
-
-    progress |= instruction_walker(*block, {[this](Object & obj) { return this->impl(obj); }},
-                                   {[this](const Object & obj) { return this->impl(obj); }});
-
+bool ConstantPropagation::operator()(const std::shared_ptr<CFGNode> & block) {
+    // In SSA form definitions come before their uses, so the uses in each
+    // instruction can be propagated before it is itself recorded as a
+    // definition
+    bool progress = false;
+    const auto & insts = block->block->instructions;
+    for (size_t i = 0; i < insts.size(); ++i) {
+        progress |= propagate(block, i);
+        progress |= define(insts[i]);
+    }
     return progress;
 }
 
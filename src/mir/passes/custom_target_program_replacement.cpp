@@ -13,7 +13,7 @@ bool custom_target_program_replacement(Object & obj) {
     }
 
     auto & fc = std::get<MIR::FunctionCallPtr>(obj);
-    if (fc->name != "custom_target") {
+    if (fc->id != Builtin::CUSTOM_TARGET) {
         return false;
     }
 
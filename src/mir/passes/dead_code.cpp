@@ -7,7 +7,7 @@
 
 namespace MIR::Passes {
 
-bool delete_unreachable(std::shared_ptr<CFGNode> block) {
+bool delete_unreachable(const std::shared_ptr<CFGNode> & block) {
     // If we see an Message object that is an error, that block will not return,
     // break it's next connection
     std::set<std::shared_ptr<CFGNode>, CFGComparitor> keep;
@@ -19,8 +19,7 @@ std::optional<Object> lower_found_method(const FunctionCallPtr & f) {
             "Dependency.found() does not take any keyword arguments");
     }
 
-    return std::make_shared<Boolean>(
-        std::get<DependencyPtr>(f->holder.value())->found);
+    return Boolean::intern(std::get<DependencyPtr>(f->holder.value())->found);
 }
 
 std::optional<Object> lower_version_method(const FunctionCallPtr & f) {
@@ -63,17 +62,17 @@ std::optional<Object> lower_dependency_objects(const Object & obj,
         return std::nullopt;
     }
 
-    if (!all_args_reduced(f->pos_args, f->kw_args)) {
+    if (!f->args_reduced()) {
         return std::nullopt;
     }
 
-    if (f->name == "found") {
+    if (f->id == Builtin::FOUND) {
         return lower_found_method(f);
     }
-    if (f->name == "version") {
+    if (f->id == Builtin::VERSION) {
         return lower_version_method(f);
     }
-    if (f->name == "name") {
+    if (f->id == Builtin::NAME) {
         return lower_name_method(f);
     }
 
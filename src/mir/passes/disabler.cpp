@@ -19,7 +19,7 @@ bool is_disabler(const Object & it) {
         auto obj = std::get<MIR::DictPtr>(it);
         return std::any_of(
             obj->value.begin(), obj->value.end(),
-            [](const std::pair<std::string, Object> & o) { return is_disabler(o.second); });
+            [](ObjectMap::const_reference o) { return is_disabler(o.second); });
     } else if (std::holds_alternative<MIR::FunctionCallPtr>(it)) {
         auto obj = std::get<MIR::FunctionCallPtr>(it);
         if (obj->holder && is_disabler(obj->holder.value())) {
@@ -31,7 +31,7 @@ bool is_disabler(const Object & it) {
         }
         return std::any_of(
             obj->kw_args.begin(), obj->kw_args.end(),
-            [](const std::pair<std::string, Object> & o) { return is_disabler(o.second); });
+            [](ObjectMap::const_reference o) { return is_disabler(o.second); });
     } else if (std::holds_alternative<MIR::JumpPtr>(it)) {
         auto obj = std::get<MIR::JumpPtr>(it);
         if (obj->predicate && is_disabler(obj->predicate.value())) {
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+#include "passes.hpp"
+#include "private.hpp"
+
+#include <cassert>
+#include <iterator>
+
+namespace MIR::Passes {
+
+DominatorTree::DominatorTree(const std::shared_ptr<CFGNode> & root) {
+    const auto cfg = CFGAnalysis::get(root);
+    order = cfg->order;
+    const auto & position = cfg->position;
+
+    // The graph is acyclic, and graph_walker visits a block only after all of
+    // its predecessors, so a single pass of the Cooper, Harvey, and Kennedy
+    // algorithm is enough to find every immediate dominator.
+    const auto & intersect = [&](uint32_t l, uint32_t r) {
+        while (l != r) {
+            while (position[l] > position[r]) {
+                l = idom.at(l);
+            }
+            while (position[r] > position[l]) {
+                r = idom.at(r);
+            }
+        }
+        return l;
+    };
+
+    idom[root->index] = root->index;
+    for (auto it = std::next(order.begin()); it != order.end(); ++it) {
+        const auto & b = *it;
+        assert(!b->predecessors.empty());
+        auto preds = b->predecessors.begin();
+        uint32_t dom = preds->lock()->index;
+        for (++preds; preds != b->predecessors.end(); ++preds) {
+            dom = intersect(dom, preds->lock()->index);
+        }
+        idom[b->index] = dom;
+    }
+
+    for (const auto & b : order) {
+        if (b->predecessors.size() < 2) {
+            continue;
+        }
+        const uint32_t dom = idom.at(b->index);
+        for (const auto & p : b->predecessors) {
+            for (uint32_t runner = p.lock()->index; runner != dom; runner = idom.at(runner)) {
+                auto & f = frontier[runner];
+                if (f.empty() || f.back() != b->index) {
+                    f.emplace_back(b->index);
+                }
+            }
+        }
+    }
+}
+
+} // namespace MIR::Passes
@@ -6,8 +6,10 @@
 #include "log.hpp"
 #include "passes.hpp"
 #include "private.hpp"
+#include "trace.hpp"
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <vector>
 
@@ -15,14 +17,19 @@ namespace MIR::Passes {
 
 namespace {
 
+/// Widen a variant of some of the Object alternatives back to an Object
+template <typename... Ts> Object to_object(const std::variant<Ts...> & v) {
+    return std::visit([](const auto & o) -> Object { return o; }, v);
+}
+
 std::optional<Object> lower_files(const FunctionCallPtr & f, const State::Persistant & pstate) {
-    auto args = extract_variadic_arguments<StringPtr>(f->pos_args.begin(), f->pos_args.end(),
-                                                      "files: arguments must be strings");
+    constexpr Signature signature{Variadic<StringPtr>{}};
+    const auto & [args] = signature(*f);
+    const auto dir = Directory::intern(f->source_dir, pstate.source_root, pstate.build_root);
     std::vector<Object> files{};
     files.reserve(args.size());
     std::transform(args.begin(), args.end(), std::back_inserter(files), [&](const StringPtr & v) {
-        return std::make_shared<File>(v->value, f->source_dir, false, pstate.source_root,
-                                      pstate.build_root);
+        return std::make_shared<File>(v->value, dir, false);
     });
 
     return std::make_shared<Array>(std::move(files));
@@ -65,21 +72,20 @@ std::optional<std::shared_ptr<T>> lower_build_target(const FunctionCallPtr & f,
         assert(false);
     }
 
-    // This doesn't handle the listified version correctly
-    if (f->pos_args.size() < 2) {
-        throw Util::Exceptions::InvalidArguments{f->name + " requires at least 2 arguments"};
-    }
-
-    auto pos_itr = f->pos_args.begin();
-
-    const auto & name = extract_positional_argument<StringPtr>(
-        *pos_itr, f->name + " first argument must be a string");
-    ++pos_itr;
+    constexpr Signature signature{
+        Positional<StringPtr>{},
+        Variadic<std::variant<StringPtr, FilePtr, CustomTargetPtr>>{1},
+        KeywordList<StringPtr>{"cpp_args"},
+        KeywordList<StaticLibraryPtr>{"link_with"},
+        KeywordList<IncludeDirectoriesPtr>{"include_directories"},
+        KeywordList<DependencyPtr>{"dependencies"},
+    };
+    const auto & [name, raw_srcs, raw_args, raw_link_with, raw_inc, deps] = signature(*f);
 
-    // skip the first argument
     std::vector<Object> srcs{};
-    for (; pos_itr != f->pos_args.end(); ++pos_itr) {
-        srcs.emplace_back(src_to_file(*pos_itr, pstate, f->source_dir));
+    srcs.reserve(raw_srcs.size());
+    for (const auto & s : raw_srcs) {
+        srcs.emplace_back(src_to_file(to_object(s), pstate, f->source_dir));
     }
 
     std::unordered_map<Toolchain::Language, std::vector<Arguments::Argument>> args{};
@@ -91,9 +97,6 @@ std::optional<std::shared_ptr<T>> lower_build_target(const FunctionCallPtr & f,
     }
 
     const auto & comp = comp_at->second.build()->compiler;
-    auto raw_args = extract_keyword_argument_a<StringPtr>(
-                        f->kw_args, "cpp_args", f->name + ": cpp_arguments must be strings")
-                        .value_or(std::vector<StringPtr>{});
     for (const auto & ra : raw_args) {
         args[Toolchain::Language::CPP].emplace_back(comp->generalize_argument(ra->value));
     }
@@ -101,21 +104,11 @@ std::optional<std::shared_ptr<T>> lower_build_target(const FunctionCallPtr & f,
     // XXX: is this going to work, or are we going to end up taking a pointer to a temporary?
     // TODO: validation
     std::vector<StaticLinkage> slink{};
-    auto raw_link_with =
-        extract_keyword_argument_a<StaticLibraryPtr>(
-            f->kw_args, "link_with",
-            f->name + ": 'link_with' keyword argument must be StaticLibrary objects")
-            .value_or(std::vector<StaticLibraryPtr>{});
     slink.reserve(raw_link_with.size());
     for (const auto & s : raw_link_with) {
         slink.emplace_back(StaticLinkMode::NORMAL, s);
     }
 
-    auto raw_inc =
-        extract_keyword_argument_a<IncludeDirectoriesPtr>(
-            f->kw_args, "include_directories",
-            f->name + ": include_directories keyword argument must be IncludeDirectory objects")
-            .value_or(std::vector<IncludeDirectoriesPtr>{});
     for (const auto & i : raw_inc) {
         for (const auto & d : i->directories) {
             args[Toolchain::Language::CPP].emplace_back(
@@ -124,10 +117,6 @@ std::optional<std::shared_ptr<T>> lower_build_target(const FunctionCallPtr & f,
         }
     }
 
-    const auto & deps = extract_keyword_argument_a<DependencyPtr>(
-                            f->kw_args, "dependencies",
-                            f->name + ": dependencies keyword argument must be Dependency objects")
-                            .value_or(std::vector<DependencyPtr>{});
     for (const auto & d : deps) {
         for (const auto & a : d->arguments) {
             args[Toolchain::Language::CPP].emplace_back(a);
@@ -141,40 +130,33 @@ std::optional<std::shared_ptr<T>> lower_build_target(const FunctionCallPtr & f,
 
 std::optional<Object> lower_include_dirs(const FunctionCallPtr & f,
                                          const State::Persistant & pstate) {
-    for (const auto & a : f->pos_args) {
-        if (!std::holds_alternative<StringPtr>(a)) {
-            throw Util::Exceptions::InvalidArguments{
-                "include_directories: all positional arguments must be strings"};
-        }
-    }
+    constexpr Signature signature{
+        Variadic<StringPtr>{},
+        Keyword<BooleanPtr>{"is_system"},
+    };
+    const auto & [raw_dirs, is_system] = signature(*f);
 
     std::vector<std::string> dirs{};
-    for (const auto & a : f->pos_args) {
-        dirs.emplace_back(std::get<StringPtr>(a)->value);
+    dirs.reserve(raw_dirs.size());
+    for (const auto & d : raw_dirs) {
+        dirs.emplace_back(d->value);
     }
 
-    auto is_system =
-        extract_keyword_argument<BooleanPtr>(
-            f->kw_args, "is_system", "include_directories: 'is_system' argument must be a boolean")
-            .value_or(std::make_shared<Boolean>(false));
-
-    return std::make_shared<IncludeDirectories>(dirs, is_system->value);
+    return std::make_shared<IncludeDirectories>(dirs, is_system && is_system.value()->value);
 }
 
 std::optional<Object> lower_messages(const FunctionCallPtr & f) {
-    MessageLevel level;
-    if (f->name == "message") {
-        level = MessageLevel::MESSAGE;
-    } else if (f->name == "warning") {
+    MessageLevel level = MessageLevel::MESSAGE;
+    if (f->id == Builtin::WARNING) {
         level = MessageLevel::WARN;
-    } else if (f->name == "error") {
+    } else if (f->id == Builtin::ERROR) {
         level = MessageLevel::ERROR;
     }
 
     // TODO: Meson accepts anything as a message bascially, without flattening.
     // Currently, Meson++ flattens everything so I'm only going to allow strings for the moment.
-    auto args = extract_variadic_arguments<StringPtr>(f->pos_args.begin(), f->pos_args.end(),
-                                                      "message: arguments must be strings");
+    constexpr Signature signature{Variadic<StringPtr>{}};
+    const auto & [args] = signature(*f);
 
     std::string message{};
     for (const auto & a : args) {
@@ -188,21 +170,16 @@ std::optional<Object> lower_messages(const FunctionCallPtr & f) {
 }
 
 std::optional<Object> lower_assert(const FunctionCallPtr & f) {
-    if (f->pos_args.empty() || f->pos_args.size() > 2) {
-        throw Util::Exceptions::InvalidArguments("assert: takes 1 or 2 arguments, got " +
-                                                 std::to_string(f->pos_args.size()));
-    }
-
-    const auto & value = extract_positional_argument<BooleanPtr>(
-        f->pos_args[0], f->name + ": First argument did not resolve to boolean");
+    constexpr Signature signature{
+        Positional<BooleanPtr>{},
+        OptionalPositional<StringPtr>{},
+    };
+    const auto & [value, raw_message] = signature(*f);
 
     if (!value->value) {
         // TODO: maye have an assert level of message?
         // TODO, how to get the original values of this?
-        std::string message;
-        if (f->pos_args.size() == 2) {
-            message = extract_positional_argument<StringPtr>(f->pos_args[1]).value()->value;
-        }
+        const std::string message = raw_message ? raw_message.value()->value : "";
         return std::make_shared<Message>(MessageLevel::ERROR, "Assertion failed: " + message);
     }
 
@@ -212,29 +189,18 @@ std::optional<Object> lower_assert(const FunctionCallPtr & f) {
 
 std::optional<Object> lower_not(const FunctionCallPtr & f) {
     // TODO: is this code actually reachable?
-    if (f->pos_args.size() != 1) {
-        throw Util::Exceptions::InvalidArguments("not: takes 1 argument, got " +
-                                                 std::to_string(f->pos_args.size()));
-    }
-
-    const auto & value = extract_positional_argument<BooleanPtr>(
-        f->pos_args[0],
-        f->name + ": attempted to negate a value that did not resolve to a boolean");
+    constexpr Signature signature{Positional<BooleanPtr>{}};
+    const auto & [value] = signature(*f);
 
-    return std::make_shared<Boolean>(!value->value);
+    return Boolean::intern(!value->value);
 }
 
 std::optional<Object> lower_neg(const FunctionCallPtr & f) {
     // TODO: is this code actually reachable?
-    if (f->pos_args.size() != 1) {
-        throw Util::Exceptions::InvalidArguments("neg: takes 1 argument, got " +
-                                                 std::to_string(f->pos_args.size()));
-    }
+    constexpr Signature signature{Positional<NumberPtr>{}};
+    const auto & [value] = signature(*f);
 
-    const auto & value = extract_positional_argument<NumberPtr>(
-        f->pos_args[0], f->name + ": attempted to negate a value that did not resolve to a number");
-
-    return std::make_shared<Number>(-value->value);
+    return Number::intern(-value->value);
 }
 
 std::optional<Object> lower_eq(const FunctionCallPtr & f) {
@@ -259,7 +225,7 @@ std::optional<Object> lower_eq(const FunctionCallPtr & f) {
     // We know that both types are the same already
     bool value;
     if (std::holds_alternative<StringPtr>(lhs)) {
-        value = std::get<StringPtr>(lhs)->value == std::get<StringPtr>(rhs)->value;
+        value = *std::get<StringPtr>(lhs) == *std::get<StringPtr>(rhs);
     } else if (std::holds_alternative<NumberPtr>(lhs)) {
         value = std::get<NumberPtr>(lhs)->value == std::get<NumberPtr>(rhs)->value;
     } else if (std::holds_alternative<BooleanPtr>(lhs)) {
@@ -268,7 +234,7 @@ std::optional<Object> lower_eq(const FunctionCallPtr & f) {
         throw Util::Exceptions::MesonException{"TODO: missing comparison operator"};
     }
 
-    return std::make_shared<Boolean>(value);
+    return Boolean::intern(value);
 }
 
 std::optional<Object> lower_ne(const FunctionCallPtr & f) {
@@ -291,7 +257,7 @@ std::optional<Object> lower_ne(const FunctionCallPtr & f) {
     // We know that both types are the same already
     bool value;
     if (std::holds_alternative<StringPtr>(lhs)) {
-        value = std::get<StringPtr>(lhs)->value != std::get<StringPtr>(rhs)->value;
+        value = *std::get<StringPtr>(lhs) != *std::get<StringPtr>(rhs);
     } else if (std::holds_alternative<NumberPtr>(lhs)) {
         value = std::get<NumberPtr>(lhs)->value != std::get<NumberPtr>(rhs)->value;
     } else if (std::holds_alternative<BooleanPtr>(lhs)) {
@@ -300,26 +266,23 @@ std::optional<Object> lower_ne(const FunctionCallPtr & f) {
         throw Util::Exceptions::MesonException{"TODO: missing comparison operator"};
     }
 
-    return std::make_shared<Boolean>(value);
+    return Boolean::intern(value);
 }
 
 std::optional<Object> lower_declare_dependency(const FunctionCallPtr & f,
                                                const State::Persistant & pstate) {
-    if (!f->pos_args.empty()) {
-        throw Util::Exceptions::InvalidArguments(
-            "declare_dependency: takes 0 positional arguments.");
-    }
+    constexpr Signature signature{
+        Keyword<StringPtr>{"version"},
+        KeywordList<StringPtr>{"compile_args"},
+        KeywordList<std::variant<StringPtr, IncludeDirectoriesPtr>>{"include_directories"},
+        KeywordList<DependencyPtr>{"dependencies"},
+    };
+    const auto & [raw_version, raw_comp_args, raw_inc_args, raw_deps] = signature(*f);
 
-    std::string version = extract_keyword_argument<StringPtr>(
-                              f->kw_args, "version",
-                              "declare_dependency: 'version' keyword argument must be a string")
-                              .value_or(std::make_shared<String>("unknown"))
-                              ->value;
+    const std::string version = raw_version ? raw_version.value()->value : "unknown";
 
     std::vector<Arguments::Argument> args{};
-    const auto & raw_comp_args = extract_keyword_argument_a<StringPtr>(
-        f->kw_args, "compile_args", f->name + ": 'compile_args' keyword argument must be strings");
-    if (raw_comp_args) {
+    if (!raw_comp_args.empty()) {
         // XXX: this assumes C++
         // should this always use gcc/g++?
         const auto & comp_at = pstate.toolchains.find(Toolchain::Language::CPP);
@@ -330,17 +293,11 @@ std::optional<Object> lower_declare_dependency(const FunctionCallPtr & f,
         }
         const auto & comp = comp_at->second.build()->compiler;
 
-        for (const auto & ra : raw_comp_args.value()) {
+        for (const auto & ra : raw_comp_args) {
             args.emplace_back(comp->generalize_argument(ra->value));
         }
     }
 
-    const auto & raw_inc_args =
-        extract_keyword_argument_av<StringPtr, IncludeDirectoriesPtr>(
-            f->kw_args, "include_directories",
-            f->name + ": 'include_directories' must be strings or IncludeDirectories objects")
-            .value_or(std::vector<std::variant<StringPtr, IncludeDirectoriesPtr>>{});
-
     for (const auto & i : raw_inc_args) {
         if (std::holds_alternative<StringPtr>(i)) {
             const auto & s = std::get<StringPtr>(i);
@@ -355,11 +312,6 @@ std::optional<Object> lower_declare_dependency(const FunctionCallPtr & f,
         }
     }
 
-    const auto & raw_deps =
-        extract_keyword_argument_a<DependencyPtr>(
-            f->kw_args, "dependencies",
-            f->name + ": 'dependencies' keyword argument must be Dependency objects")
-            .value_or(std::vector<DependencyPtr>{});
     for (const auto & d : raw_deps) {
         const auto & dargs = d->arguments;
         std::copy(dargs.begin(), dargs.end(), std::back_inserter(args));
@@ -392,26 +344,17 @@ struct OutputReducer {
 };
 
 std::optional<Object> lower_test(const FunctionCallPtr & f, const State::Persistant & pstate) {
-    if (f->pos_args.size() != 2) {
-        throw Util::Exceptions::InvalidArguments("test: takes 2 positional arguments.");
-    }
-
-    auto && name = extract_positional_argument<StringPtr>(
-        f->pos_args.at(0), f->name + ": first argument must be a string");
-
-    // TODO: should also allow CustomTarget and Jar
-    auto && prog_v =
-        extract_positional_argument_v<MIR::FilePtr, MIR::ProgramPtr, MIR::ExecutablePtr>(
-            f->pos_args.at(1), f->name + ": got an invalid type for program");
+    // TODO: should also allow CustomTarget and Jar for the program
+    // TODO: Also allows targets in args
+    constexpr Signature signature{
+        Positional<StringPtr>{},
+        Positional<std::variant<FilePtr, ProgramPtr, ExecutablePtr>>{},
+        KeywordList<std::variant<StringPtr, FilePtr, CustomTargetPtr>>{"args"},
+        Keyword<BooleanPtr>{"should_fail"},
+    };
+    const auto & [name, prog_v, raw_args, should_fail] = signature(*f);
     const Callable & prog = std::visit(CallableReducer{}, prog_v);
 
-    // TODO: Also allows targets
-    auto && raw_args =
-        extract_keyword_argument_av<MIR::StringPtr, MIR::FilePtr, MIR::CustomTargetPtr>(
-            f->kw_args, "args",
-            f->name + ": 'args' keyword arguments must be strings, files, or custom_target objects")
-            .value_or(
-                std::vector<std::variant<MIR::StringPtr, MIR::FilePtr, MIR::CustomTargetPtr>>{});
     std::vector<std::variant<MIR::StringPtr, MIR::FilePtr>> arguments;
     for (auto && a : raw_args) {
         for (auto && n : std::visit(OutputReducer{}, a)) {
@@ -419,17 +362,12 @@ std::optional<Object> lower_test(const FunctionCallPtr & f, const State::Persist
         }
     }
 
-    const bool xfail =
-        extract_keyword_argument<MIR::BooleanPtr>(f->kw_args, "should_fail",
-                                                  "test: 'should_fail' argument must be a boolean")
-            .value_or(std::make_shared<MIR::Boolean>(false))
-            ->value;
+    const bool xfail = should_fail && should_fail.value()->value;
 
     return std::make_shared<Test>(name->value, prog, arguments, xfail);
 }
 
-std::vector<Object> extract_source_inputs(const std::unordered_map<std::string, Object> & kws,
-                                          const std::string & name,
+std::vector<Object> extract_source_inputs(const ObjectMap & kws, std::string_view name,
                                           const fs::path & current_source_dir,
                                           const State::Persistant & pstate) {
     const auto & obj = kws.find(name);
@@ -505,7 +443,7 @@ std::vector<std::string> extract_ct_command(const Object & obj, const std::vecto
         "custom_target: 'commands' must be strings, files, or find_program objects");
 }
 
-std::vector<std::string> extract_ct_command(const std::unordered_map<std::string, Object> & kws,
+std::vector<std::string> extract_ct_command(const ObjectMap & kws,
                                             const std::vector<Object> & inputs,
                                             const std::vector<FilePtr> & outputs) {
     const auto & cmd_obj = kws.find("command");
@@ -529,19 +467,24 @@ std::vector<std::string> extract_ct_command(const std::unordered_map<std::string
 
 std::optional<Object> lower_custom_target(const FunctionCallPtr & func,
                                           const State::Persistant & pstate) {
+    // input and command are checked as they are converted
+    constexpr Signature signature{
+        OptionalPositional<StringPtr>{},
+        KeywordList<StringPtr>{"output", true},
+    };
+    const auto & [raw_name, raw_outs] = signature(*func);
+
     const std::vector<Object> & inputs =
         extract_source_inputs(func->kw_args, "input", func->source_dir, pstate);
 
+    const auto dir = Directory::intern(func->source_dir, pstate.source_root, pstate.build_root);
     std::vector<FilePtr> outputs{};
-    auto && raw_outs =
-        extract_keyword_argument_a<StringPtr>(func->kw_args, "output",
-                                              "custom_target: output arguments must be strings")
-            .value_or(std::vector<StringPtr>{});
     for (const auto & a : raw_outs) {
-        outputs.emplace_back(std::make_shared<File>(a->value, func->source_dir, true,
-                                                    pstate.source_root, pstate.build_root));
+        outputs.emplace_back(std::make_shared<File>(a->value, dir, true));
+    }
+    if (outputs.empty()) {
+        throw Util::Exceptions::InvalidArguments{"custom_target: 'output' must not be empty"};
     }
-    const auto & raw_name = extract_positional_argument<StringPtr>(func->pos_args[0]);
     const std::string & name = raw_name ? raw_name.value()->value : outputs[0]->name;
 
     // TODO: output and input substitution
@@ -560,22 +503,19 @@ enum class ArgumentScope {
 
 std::optional<Object> lower_add_arguments(const FunctionCallPtr & func, const ArgumentScope scope,
                                           const State::Persistant & pstate) {
-    const auto langs = extract_keyword_argument_a<MIR::StringPtr>(
-        func->kw_args, "language", func->name + ": 'language' keyword argument must be strings");
-    if (!langs) {
-        throw Util::Exceptions::MesonException(func->name + ": missing required kwarg 'language'");
-    }
+    constexpr Signature signature{
+        Variadic<StringPtr>{},
+        KeywordList<StringPtr>{"language", true},
+    };
+    const auto & [arguments, langs] = signature(*func);
 
-    const auto arguments = extract_variadic_arguments<MIR::StringPtr>(
-        func->pos_args.begin(), func->pos_args.end(),
-        func->name + ": positional arguments must be strings");
     // Meson allows this, so if we don't get any arguments, just return an empty to delete the node
     if (arguments.empty()) {
         return std::nullopt;
     }
 
     ArgMap mapping;
-    for (auto && s : langs.value()) {
+    for (auto && s : langs) {
         const Toolchain::Language lang = Toolchain::from_string(s->value);
         if (const auto & tc = pstate.toolchains.find(lang); tc != pstate.toolchains.end()) {
             for (auto && arg : arguments) {
@@ -590,39 +530,27 @@ std::optional<Object> lower_add_arguments(const FunctionCallPtr & func, const Ar
 };
 
 std::optional<Object> lower_vcs_tag(const FunctionCallPtr & f, const State::Persistant & p) {
-    if (!f->pos_args.empty()) {
-        throw Util::Exceptions::InvalidArguments(
-            "vcs_tag: does not take any positional arguments.");
-    }
-    if (f->kw_args.find("input") == f->kw_args.end()) {
-        throw Util::Exceptions::InvalidArguments(
-            "vcs_tag: missing required keyword argument input.");
-    }
-    if (f->kw_args.find("output") == f->kw_args.end()) {
-        throw Util::Exceptions::InvalidArguments(
-            "vcs_tag: missing required keyword argument output.");
-    }
+    constexpr Signature signature{
+        Keyword<std::variant<StringPtr, FilePtr>>{"input", true},
+        Keyword<StringPtr>{"output", true},
+        Keyword<StringPtr>{"fallback"},
+        Keyword<StringPtr>{"replace_string"},
+    };
+    const auto & [raw_input, output, raw_fallback, raw_replace] = signature(*f);
     if (f->kw_args.find("command") != f->kw_args.end()) {
         throw Util::Exceptions::MesonException(
             "Not implemented: vcs_tag 'command' keyword argument");
     }
 
-    Object input = src_to_file(f->kw_args.find("input")->second, p, f->source_dir);
-    auto output = extract_keyword_argument<MIR::StringPtr>(f->kw_args, "output",
-                                                           f->name + ": 'output' must be a string")
-                      .value();
+    Object input = src_to_file(to_object(raw_input.value()), p, f->source_dir);
     // TODO: get version from project() call
-    auto fallback = extract_keyword_argument<MIR::StringPtr>(
-                        f->kw_args, "fallback", f->name + ": 'fallback' must be a string")
-                        .value_or(std::make_shared<MIR::String>(p.project_version));
-    auto replace_string =
-        extract_keyword_argument<MIR::StringPtr>(f->kw_args, "replace_string",
-                                                 f->name + ": 'replace_string' must be a string")
-            .value_or(std::make_shared<MIR::String>("@VCS_TAG@"));
-
-    auto outfile =
-        std::make_shared<File>(output->value, f->source_dir, true, p.source_root, p.build_root);
-    const auto src = std::get<FilePtr>(src_to_file(input, p, f->source_dir));
+    const std::string & fallback = raw_fallback ? raw_fallback.value()->value : p.project_version;
+    const std::string & replace_string =
+        raw_replace ? raw_replace.value()->value : std::string{"@VCS_TAG@"};
+
+    auto outfile = std::make_shared<File>(output.value()->value, f->source_dir, true,
+                                          p.source_root, p.build_root);
+    const auto src = std::get<FilePtr>(input);
 
     const std::string depfile = outfile->relative_to_build_dir().string() + ".d";
 
@@ -633,8 +561,8 @@ std::optional<Object> lower_vcs_tag(const FunctionCallPtr & f, const State::Pers
         "vcs_tag",
         src->relative_to_build_dir(),
         outfile->relative_to_build_dir(),
-        fallback->value,
-        replace_string->value,
+        fallback,
+        replace_string,
         p.source_root,
         depfile,
     };
@@ -644,6 +572,74 @@ std::optional<Object> lower_vcs_tag(const FunctionCallPtr & f, const State::Pers
                                           std::vector<FilePtr>{}, depfile);
 }
 
+using Lowering = std::optional<Object> (*)(const FunctionCallPtr &, const State::Persistant &);
+
+/// The lowering of each free function, indexed by Builtin, or nullptr if it isn't a free function
+constexpr auto free_functions = [] {
+    std::array<Lowering, builtin_count> t{};
+    const auto & set = [&t](Builtin b, Lowering l) { t[static_cast<size_t>(b)] = l; };
+
+    set(Builtin::REL_EQ, [](const FunctionCallPtr & f, const State::Persistant &) {
+        return lower_eq(f);
+    });
+    set(Builtin::REL_NE, [](const FunctionCallPtr & f, const State::Persistant &) {
+        return lower_ne(f);
+    });
+    set(Builtin::UNARY_NOT, [](const FunctionCallPtr & f, const State::Persistant &) {
+        return lower_not(f);
+    });
+    set(Builtin::UNARY_NEG, [](const FunctionCallPtr & f, const State::Persistant &) {
+        return lower_neg(f);
+    });
+    set(Builtin::ASSERT, [](const FunctionCallPtr & f, const State::Persistant &) {
+        return lower_assert(f);
+    });
+    for (const Builtin b : {Builtin::MESSAGE, Builtin::WARNING, Builtin::ERROR}) {
+        set(b, [](const FunctionCallPtr & f, const State::Persistant &) {
+            return lower_messages(f);
+        });
+    }
+    set(Builtin::INCLUDE_DIRECTORIES, lower_include_dirs);
+    set(Builtin::FILES, lower_files);
+    set(Builtin::CUSTOM_TARGET, lower_custom_target);
+    set(Builtin::EXECUTABLE, [](const FunctionCallPtr & f, const State::Persistant & pstate) {
+        return std::optional<Object>{lower_build_target<Executable>(f, pstate)};
+    });
+    set(Builtin::STATIC_LIBRARY, [](const FunctionCallPtr & f, const State::Persistant & pstate) {
+        return std::optional<Object>{lower_build_target<StaticLibrary>(f, pstate)};
+    });
+    set(Builtin::DECLARE_DEPENDENCY, lower_declare_dependency);
+    set(Builtin::VCS_TAG, lower_vcs_tag);
+    set(Builtin::TEST, lower_test);
+    set(Builtin::ADD_PROJECT_ARGUMENTS,
+        [](const FunctionCallPtr & f, const State::Persistant & pstate) {
+            return lower_add_arguments(f, ArgumentScope::project_comp, pstate);
+        });
+    set(Builtin::ADD_PROJECT_LINK_ARGUMENTS,
+        [](const FunctionCallPtr & f, const State::Persistant & pstate) {
+            return lower_add_arguments(f, ArgumentScope::project_link, pstate);
+        });
+    set(Builtin::ADD_GLOBAL_ARGUMENTS,
+        [](const FunctionCallPtr & f, const State::Persistant & pstate) {
+            return lower_add_arguments(f, ArgumentScope::global_comp, pstate);
+        });
+    set(Builtin::ADD_GLOBAL_LINK_ARGUMENTS,
+        [](const FunctionCallPtr & f, const State::Persistant & pstate) {
+            return lower_add_arguments(f, ArgumentScope::global_link, pstate);
+        });
+    set(Builtin::DISABLER, [](const FunctionCallPtr &, const State::Persistant &) {
+        return std::optional<Object>{std::make_shared<Disabler>()};
+    });
+
+    // These are handled elsewhere
+    for (const Builtin b : {Builtin::FIND_PROGRAM, Builtin::DEPENDENCY}) {
+        set(b, [](const FunctionCallPtr &, const State::Persistant &) {
+            return std::optional<Object>{};
+        });
+    }
+    return t;
+}();
+
 } // namespace
 
 std::optional<Object> lower_free_functions(const Object & obj, const State::Persistant & pstate) {
@@ -657,72 +653,22 @@ std::optional<Object> lower_free_functions(const Object & obj, const State::Pers
         return std::nullopt;
     }
 
-    if (!all_args_reduced(f->pos_args, f->kw_args)) {
+    if (!f->args_reduced()) {
         return std::nullopt;
     }
 
-    std::optional<Object> i = std::nullopt;
-
-    if (f->name == "rel_eq") {
-        i = lower_eq(f);
-    } else if (f->name == "rel_ne") {
-        i = lower_ne(f);
-    } else if (f->name == "unary_not") {
-        i = lower_not(f);
-    } else if (f->name == "unary_neg") {
-        i = lower_neg(f);
-    } else if (f->name == "assert") {
-        i = lower_assert(f);
-    } else if (f->name == "message" || f->name == "warning" || f->name == "error") {
-        i = lower_messages(f);
-    } else if (f->name == "include_directories") {
-        i = lower_include_dirs(f, pstate);
-    } else if (f->name == "files") {
-        i = lower_files(f, pstate);
-    } else if (f->name == "custom_target") {
-        i = lower_custom_target(f, pstate);
-    } else if (f->name == "executable") {
-        i = lower_build_target<Executable>(f, pstate);
-    } else if (f->name == "static_library") {
-        i = lower_build_target<StaticLibrary>(f, pstate);
-    } else if (f->name == "declare_dependency") {
-        i = lower_declare_dependency(f, pstate);
-    } else if (f->name == "vcs_tag") {
-        i = lower_vcs_tag(f, pstate);
-    } else if (f->name == "test") {
-        i = lower_test(f, pstate);
-    } else if (f->name == "add_project_arguments") {
-        i = lower_add_arguments(f, ArgumentScope::project_comp, pstate);
-    } else if (f->name == "add_project_link_arguments") {
-        i = lower_add_arguments(f, ArgumentScope::project_link, pstate);
-    } else if (f->name == "add_global_arguments") {
-        i = lower_add_arguments(f, ArgumentScope::global_comp, pstate);
-    } else if (f->name == "add_global_link_arguments") {
-        i = lower_add_arguments(f, ArgumentScope::global_link, pstate);
-    } else if (f->name == "disabler") {
-        i = std::make_shared<Disabler>();
-    } else if (f->name == "find_program" || f->name == "dependency") {
-        // These are handled elsewhere
-        return std::nullopt;
-    } else {
+    const Lowering lower = free_functions[static_cast<size_t>(f->id)];
+    if (lower == nullptr) {
         throw Util::Exceptions::MesonException("Unexpected function name: '" + f->name + "'");
     }
 
+    std::optional<Object> i = lower(f, pstate);
     if (i) {
         MIR::set_var(obj, i.value());
     }
     return i;
 }
 
-bool all_args_reduced(const std::vector<Object> & pos_args,
-                      const std::unordered_map<std::string, Object> & kw_args) {
-    const auto reduced = [](auto && obj) { return obj->is_reduced(); };
-    return std::all_of(pos_args.begin(), pos_args.end(),
-                       [&reduced](auto && p) { return std::visit(reduced, p); }) &&
-           std::all_of(kw_args.begin(), kw_args.end(),
-                       [&reduced](auto && kw) { return std::visit(reduced, kw.second); });
-}
-
 void lower_project(std::shared_ptr<CFGNode> block, State::Persistant & pstate) {
     const auto & obj = block->block->instructions.front();
 
@@ -732,26 +678,25 @@ void lower_project(std::shared_ptr<CFGNode> block, State::Persistant & pstate) {
     }
     const auto & f = std::get<FunctionCallPtr>(obj);
 
-    if (f->name != "project") {
+    if (f->id != Builtin::PROJECT) {
         throw Util::Exceptions::MesonException{
             "First non-whitespace, non-comment must be a call to project()"};
     }
 
-    // This doesn't handle the listified version corretly
-    if (f->pos_args.empty()) {
-        throw Util::Exceptions::InvalidArguments{"project requires at least 1 argument"};
-    }
-
-    auto pos = f->pos_args.begin();
+    constexpr Signature signature{
+        Positional<StringPtr>{},
+        Variadic<StringPtr>{},
+        Keyword<StringPtr>{"version"},
+    };
+    const auto & [name, langs, version] = signature(*f);
 
-    pstate.name = std::get<StringPtr>(*pos)->value;
+    pstate.name = name->value;
     // TODO: I don't want this in here, I'd rather have this all done in the backend, I think
     std::cout << "Project name: " << Util::Log::bold(pstate.name) << std::endl;
 
-    const auto & langs = extract_variadic_arguments<StringPtr>(
-        ++pos, f->pos_args.end(), "project: Language arguments must be strings");
     for (const auto & lang : langs) {
         const auto l = Toolchain::from_string(lang->value);
+        Util::Trace::Scope trace{"mir", [&] { return "detect " + lang->value + " toolchain"; }};
 
         auto & tc = pstate.toolchains[l];
 
@@ -774,16 +719,13 @@ void lower_project(std::shared_ptr<CFGNode> block, State::Persistant & pstate) {
                   << ")" << std::endl;
     }
 
-    auto version = extract_keyword_argument<MIR::StringPtr>(f->kw_args, "version",
-                                                            "project: 'version' must be a string")
-                       .value_or(std::make_shared<MIR::String>("unknown"));
-    pstate.project_version = version->value;
+    pstate.project_version = version ? version.value()->value : "unknown";
 
     // TODO: handle remaining keyword arguments
 
     // Remove the valid project() call so we don't accidently find it later when
     // looking for invalid function calls.
-    block->block->instructions.pop_front();
+    block->block->instructions.erase(block->block->instructions.begin());
 }
 
 } // namespace MIR::Passes
@@ -6,7 +6,7 @@
 
 namespace MIR::Passes {
 
-bool fixup_phis(std::shared_ptr<CFGNode> block) {
+bool fixup_phis(const std::shared_ptr<CFGNode> & block) {
     bool progress = false;
     for (auto it = block->block->instructions.begin(); it != block->block->instructions.end();
          ++it) {
@@ -38,8 +38,7 @@ bool fixup_phis(std::shared_ptr<CFGNode> block) {
                 const Variable & var = std::visit(VariableGetter{}, *it);
                 auto id = std::make_shared<Identifier>(var.name, left ? phi->left : phi->right);
                 id->var = var;
-                it = block->block->instructions.erase(it);
-                it = block->block->instructions.emplace(it, std::move(id));
+                *it = std::move(id);
                 continue;
             }
 
@@ -61,8 +60,7 @@ bool fixup_phis(std::shared_ptr<CFGNode> block) {
                 const Variable & var = std::visit(VariableGetter{}, *it);
                 auto id = std::make_shared<Identifier>(var.name, left ? phi->left : phi->right);
                 id->var = var;
-                it = block->block->instructions.erase(it);
-                it = block->block->instructions.emplace(it, std::move(id));
+                *it = std::move(id);
             }
         }
     }
@@ -4,12 +4,13 @@
 #include "passes.hpp"
 
 #include <cassert>
+#include <iterator>
 
 namespace MIR::Passes {
 
 namespace {
 
-bool join_blocks_impl(std::shared_ptr<CFGNode> block) {
+bool join_blocks_impl(const std::shared_ptr<CFGNode> & block) {
     // If we don't have exactly one successor we can't join any blocks together
     if (block->successors.size() != 1) {
         return false;
@@ -36,7 +37,11 @@ bool join_blocks_impl(std::shared_ptr<CFGNode> block) {
         unlink_nodes(next, *next->successors.begin(), false);
     }
     // Move the instructions
-    block->block->instructions.splice(block->block->instructions.end(), next->block->instructions);
+    auto & instructions = block->block->instructions;
+    auto & next_instructions = next->block->instructions;
+    instructions.insert(instructions.end(), std::make_move_iterator(next_instructions.begin()),
+                        std::make_move_iterator(next_instructions.end()));
+    next_instructions.clear();
     unlink_nodes(block, next, false);
 
     return true;
@@ -44,7 +49,7 @@ bool join_blocks_impl(std::shared_ptr<CFGNode> block) {
 
 } // namespace
 
-bool join_blocks(std::shared_ptr<CFGNode> block) {
+bool join_blocks(const std::shared_ptr<CFGNode> & block) {
     bool progress = false;
     bool lprogress;
 
@@ -26,20 +26,20 @@ std::optional<Machine> machine_map(const std::string & func_name) {
     return std::nullopt;
 }
 
-Object lower_function(const std::string & holder, const std::string & name, const Info & info) {
-    if (name == "cpu_family") {
+Object lower_function(const std::string & holder, const FunctionCall & f, const Info & info) {
+    if (f.id == Builtin::CPU_FAMILY) {
         return std::make_shared<MIR::String>(info.cpu_family);
     }
-    if (name == "cpu") {
+    if (f.id == Builtin::CPU) {
         return std::make_shared<MIR::String>(info.cpu);
     }
-    if (name == "system") {
+    if (f.id == Builtin::SYSTEM) {
         return std::make_shared<MIR::String>(info.system());
     }
-    if (name == "endian") {
+    if (f.id == Builtin::ENDIAN) {
         return std::make_shared<MIR::String>(info.endian == Endian::LITTLE ? "little" : "big");
     }
-    throw Util::Exceptions::MesonException{holder + " has no method " + name};
+    throw Util::Exceptions::MesonException{holder + " has no method " + f.name};
 }
 
 using MachineInfo = PerMachine<Info>;
@@ -56,7 +56,7 @@ std::optional<Object> machine_lower(const Object & obj, const MachineInfo & mach
             if (maybe_m.has_value()) {
                 const auto & info = machines.get(maybe_m.value());
 
-                Object i = lower_function(holder, f->name, info);
+                Object i = lower_function(holder, *f, info);
                 MIR::set_var(obj, i);
                 return i;
             }
@@ -34,7 +34,7 @@ void Printer::increment() {
     }
 }
 
-bool Printer::operator()(const std::shared_ptr<CFGNode> block) {
+bool Printer::operator()(const std::shared_ptr<CFGNode> & block) {
     if (out.is_open()) {
         // Only print a given block once
         out << "  CFGNode " << block->index << " {\n";
@@ -8,7 +8,10 @@
 #pragma once
 
 #include "mir.hpp"
+#include <cstdint>
 #include <functional>
+#include <type_traits>
+#include <variant>
 
 namespace MIR::Passes {
 
@@ -19,25 +22,176 @@ using ReplacementCallback = std::function<std::optional<Object>(const Object &)>
 using MutationCallback = std::function<bool(Object &)>;
 
 /// Callback to pass to a BlockWalker, probably an instruction_walker
-using BlockWalkerCb = std::function<bool(std::shared_ptr<CFGNode>)>;
+using BlockWalkerCb = std::function<bool(const std::shared_ptr<CFGNode> &)>;
+
+/// A set of Object alternatives, with one bit for each alternative's index
+using ObjectMask = uint64_t;
+static_assert(std::variant_size_v<Object> <= 64, "ObjectMask is too small for Object");
+
+namespace detail {
+
+template <typename T, size_t I = 0> constexpr size_t object_index() {
+    if constexpr (std::is_same_v<std::variant_alternative_t<I, Object>, T>) {
+        return I;
+    } else {
+        return object_index<T, I + 1>();
+    }
+}
+
+} // namespace detail
+
+/// Build an ObjectMask matching the given Object alternatives
+template <typename... T> constexpr ObjectMask object_mask() {
+    return ((ObjectMask{1} << detail::object_index<T>()) | ...);
+}
+
+/// An ObjectMask that matches every alternative
+constexpr ObjectMask ALL_OBJECTS = ~ObjectMask{0};
+
+/**
+ * A ReplacementCallback, and the Object alternatives it wants to be called on
+ *
+ * The walker checks the mask before calling the callback, so passes that only
+ * handle a few kinds of object do not pay for a std::function call on every
+ * node.
+ */
+struct ReplacementPass {
+    template <typename F,
+              typename = std::enable_if_t<std::is_constructible_v<ReplacementCallback, F>>>
+    ReplacementPass(F && cb, ObjectMask types_ = ALL_OBJECTS)
+        : callback{std::forward<F>(cb)}, types{types_} {}
+
+    bool wants(const Object & obj) const { return (types >> obj.index()) & 1; }
+
+    ReplacementCallback callback;
+    ObjectMask types;
+};
 
 /**
  * Walks each instruction in a basic block, calling each callback on each instruction
  *
+ * Each instruction is descended once. Children are visited before their
+ * parents, and at each node every replacement callback that wants it is called
+ * in order, with later callbacks seeing the result of earlier replacements.
+ * The mutation callbacks are then run in a second descent.
+ *
  * Returns true if any changes were made to the block.
  */
 bool instruction_walker(CFGNode &, const std::vector<MutationCallback> &,
-                        const std::vector<ReplacementCallback> &);
+                        const std::vector<ReplacementPass> &);
 bool instruction_walker(CFGNode &, const std::vector<MutationCallback> &);
-bool instruction_walker(CFGNode &, const std::vector<ReplacementCallback> &);
+bool instruction_walker(CFGNode &, const std::vector<ReplacementPass> &);
+
+/// Walk a single instruction, in the same way instruction_walker walks each instruction of a block
+bool instruction_walker(Object &, const std::vector<MutationCallback> &,
+                        const std::vector<ReplacementPass> &);
+
+/**
+ * Cached analysis of the shape of a graph
+ *
+ * Walking a graph in order needs a queue, a set of the blocks already walked,
+ * and a check of the predecessors of each block. The graph is walked many times
+ * on each lowering iteration, but its shape rarely changes, so the walk order is
+ * stored here as flat arrays, and only recalculated once link_nodes or
+ * unlink_nodes has been called.
+ */
+class CFGAnalysis {
+  public:
+    /// Used in `position` for blocks that are not reachable from the root
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    /**
+     * Get the analysis of the graph starting at root, recalculating it if the graph has changed
+     *
+     * The cache is not locked, so this must only be called from the main
+     * thread. The cached analysis holds every block of the graph alive until
+     * it is replaced or `reset()` is called.
+     */
+    static std::shared_ptr<const CFGAnalysis> get(const std::shared_ptr<CFGNode> & root);
+
+    /// Drop the cached analysis, releasing the blocks it holds
+    static void reset();
+
+    explicit CFGAnalysis(const std::shared_ptr<CFGNode> & root);
+
+    /// Whether the graph has been changed since this analysis was calculated
+    bool stale() const { return epoch != cfg_epoch(); }
+
+    /// The positions of the predecessors of the block at position i
+    std::pair<const uint32_t *, const uint32_t *> predecessors(uint32_t i) const {
+        return {predecessor_list.data() + predecessor_offsets[i],
+                predecessor_list.data() + predecessor_offsets[i + 1]};
+    }
+
+    /// The reachable blocks in the order graph_walker visits them
+    std::vector<std::shared_ptr<CFGNode>> order;
+
+    /// The position of each block in `order`, indexed by CFGNode::index
+    std::vector<uint32_t> position;
+
+    /// How many of the blocks after each one in `order` had been queued when it was reached
+    std::vector<uint32_t> queued;
+
+  private:
+    /// Offsets into `predecessor_list` for each position, plus one past the end
+    std::vector<uint32_t> predecessor_offsets;
+    std::vector<uint32_t> predecessor_list;
+
+    const uint32_t root;
+    const uint64_t epoch;
+};
 
 /**
  * Walker over all basic blocks starting with the provided one, applying the given callbacks
+ *
+ * The order comes from the CFGAnalysis cache. If a callback changes the shape
+ * of the graph the rest of the walk follows the changed graph instead.
  */
 bool graph_walker(std::shared_ptr<CFGNode>, const std::vector<BlockWalkerCb> &);
 
-/// Check if all of the arguments have been reduced from ids
-bool all_args_reduced(const std::vector<Object> & pos_args,
-                      const std::unordered_map<std::string, Object> & kw_args);
+/**
+ * Runs block passes over the graph, revisiting only the blocks that may change
+ *
+ * Calling graph_walker until it stops making progress runs every pass over
+ * every block, even when the previous iteration changed only a single
+ * instruction. The PassManager instead tracks which blocks are dirty. A block
+ * becomes clean once the passes run over it without making progress, and stays
+ * clean until something it depends on changes.
+ *
+ * Since MIR is in SSA form every use of a value is in a block reachable from
+ * the block that defines it, so when a block makes progress every block
+ * reachable from it is walked again in the same iteration. When a pass changes
+ * the successors of a block every block is made dirty, as pruning or joining
+ * blocks can enable work in blocks that are not reachable from the changed one.
+ */
+class PassManager {
+  public:
+    PassManager(std::vector<BlockWalkerCb> passes);
+
+    /**
+     * Run the passes over each dirty block
+     *
+     * Returns true if any pass made progress, in which case it needs to be
+     * called again.
+     */
+    bool operator()(const std::shared_ptr<CFGNode> & root);
+
+    /// Mark every block as dirty, for use when the graph has been modified outside of the manager
+    void invalidate();
+
+  private:
+    const std::vector<BlockWalkerCb> passes;
+
+    /// Blocks that need no further work, indexed by CFGNode::index
+    std::vector<bool> clean;
+
+    /// Blocks that changed, or are reachable from one that did, in the current iteration
+    std::vector<bool> changed;
+
+    /// The successors of the current block before the passes were run
+    std::vector<const CFGNode *> successors;
+
+    bool successors_changed(const CFGNode &) const;
+};
 
 } // namespace MIR::Passes
@@ -20,7 +20,7 @@ std::optional<Object> lower_found_method(const FunctionCallPtr & f) {
     }
 
     assert(f->holder.has_value());
-    return std::make_shared<Boolean>(std::get<ProgramPtr>(f->holder.value())->found());
+    return Boolean::intern(std::get<ProgramPtr>(f->holder.value())->found());
 }
 
 } // namespace
@@ -35,12 +35,12 @@ std::optional<Object> lower_program_objects(const Object & obj, const State::Per
         return std::nullopt;
     }
 
-    if (!all_args_reduced(f->pos_args, f->kw_args)) {
+    if (!f->args_reduced()) {
         return std::nullopt;
     }
 
     std::optional<Object> i = std::nullopt;
-    if (f->name == "found") {
+    if (f->id == Builtin::FOUND) {
         i = lower_found_method(f);
     }
     if (i) {
@@ -2,6 +2,7 @@
 // Copyright © 2021-2025 Intel Corporation
 
 #include <algorithm>
+#include <iterator>
 
 #include "passes.hpp"
 
@@ -9,7 +10,7 @@ namespace MIR::Passes {
 
 namespace {
 
-bool branch_pruning_impl(std::shared_ptr<CFGNode> node) {
+bool branch_pruning_impl(const std::shared_ptr<CFGNode> & node) {
     // If we don't have at least 2 potential exits from this block then we don't
     // have anything to do
     if (node->successors.size() < 2) {
@@ -20,7 +21,8 @@ bool branch_pruning_impl(std::shared_ptr<CFGNode> node) {
 
     // XXX: this heavily assumes that there is one and only one way to get from
     // one node to a second node. That is not true
-    for (auto it = node->block->instructions.begin(); it != node->block->instructions.end(); ++it) {
+    auto it = node->block->instructions.begin();
+    while (it != node->block->instructions.end()) {
         if (std::holds_alternative<JumpPtr>(*it)) {
             JumpPtr j = std::get<JumpPtr>(*it);
             if (j->predicate) {
@@ -36,10 +38,8 @@ bool branch_pruning_impl(std::shared_ptr<CFGNode> node) {
                                 unlink_nodes(node, s);
                             }
                         }
-                        it++;
-                        while (it != node->block->instructions.end()) {
-                            it = node->block->instructions.erase(it);
-                        }
+                        node->block->instructions.erase(std::next(it),
+                                                        node->block->instructions.end());
                         return true;
                     } else {
                         // Otherwise, if the predicate is false, then we can unlink it's
@@ -79,16 +79,16 @@ bool branch_pruning_impl(std::shared_ptr<CFGNode> node) {
             }
 
             if (b->branches.size() == 1) {
-                auto jump = std::make_shared<Jump>(std::get<1>(b->branches.at(0)));
-                it = node->block->instructions.erase(it);
-                it = node->block->instructions.emplace(it, std::move(jump));
+                *it = std::make_shared<Jump>(std::get<1>(b->branches.at(0)));
                 progress |= true;
             } else if (b->branches.empty()) {
                 assert(node->successors.empty());
                 it = node->block->instructions.erase(it);
                 progress |= true;
+                continue;
             }
         }
+        ++it;
     }
 
     return progress;
@@ -96,7 +96,7 @@ bool branch_pruning_impl(std::shared_ptr<CFGNode> node) {
 
 } // namespace
 
-bool branch_pruning(std::shared_ptr<CFGNode> block) {
+bool branch_pruning(const std::shared_ptr<CFGNode> & block) {
     bool progress = false;
     bool lprogress;
 
@@ -63,7 +63,7 @@ std::optional<Object> lower_version_compare_method(const FunctionCallPtr & f) {
             c->value);
     }
 
-    return std::make_shared<Boolean>(Version::compare(s->value, op, val));
+    return Boolean::intern(Version::compare(s->value, op, val));
 }
 
 } // namespace
@@ -78,12 +78,12 @@ std::optional<Object> lower_string_objects(const Object & obj, const State::Pers
         return std::nullopt;
     }
 
-    if (!all_args_reduced(f->pos_args, f->kw_args)) {
+    if (!f->args_reduced()) {
         return std::nullopt;
     }
 
     std::optional<Object> i = std::nullopt;
-    if (f->name == "version_compare") {
+    if (f->id == Builtin::VERSION_COMPARE) {
         i = lower_version_compare_method(f);
     }
 
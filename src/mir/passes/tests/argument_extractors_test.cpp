@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+#include "exceptions.hpp"
+#include "passes/argument_extractors.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace MIR::Passes;
+
+namespace {
+
+constexpr Signature signature{
+    Positional<MIR::StringPtr>{},
+    OptionalPositional<MIR::NumberPtr>{},
+    Keyword<MIR::BooleanPtr>{"flag"},
+    KeywordList<std::variant<MIR::StringPtr, MIR::NumberPtr>>{"list", true},
+};
+
+static_assert(detail::positionals_ordered<Positional<MIR::StringPtr>, Keyword<MIR::BooleanPtr>,
+                                          OptionalPositional<MIR::NumberPtr>,
+                                          Variadic<MIR::StringPtr>>());
+static_assert(!detail::positionals_ordered<OptionalPositional<MIR::NumberPtr>,
+                                           Positional<MIR::StringPtr>>());
+static_assert(!detail::positionals_ordered<Variadic<MIR::StringPtr>, Positional<MIR::StringPtr>>());
+
+} // namespace
+
+TEST(signature, simple) {
+    std::vector<MIR::Object> pos{std::make_shared<MIR::String>("name")};
+    MIR::ObjectMap kw{
+        {"list", std::make_shared<MIR::Array>(std::vector<MIR::Object>{
+                     std::make_shared<MIR::String>("a"), std::make_shared<MIR::Number>(1)})},
+    };
+    const MIR::FunctionCall f{"func", std::move(pos), std::move(kw), ""};
+
+    const auto & [name, num, flag, list] = signature(f);
+    EXPECT_EQ(name->value, "name");
+    EXPECT_FALSE(num.has_value());
+    EXPECT_FALSE(flag.has_value());
+    ASSERT_EQ(list.size(), 2U);
+    EXPECT_EQ(std::get<MIR::StringPtr>(list[0])->value, "a");
+    EXPECT_EQ(std::get<MIR::NumberPtr>(list[1])->value, 1);
+}
+
+TEST(signature, invalid) {
+    const auto & call = [](std::vector<MIR::Object> && pos, MIR::ObjectMap && kw) {
+        return MIR::FunctionCall{"func", std::move(pos), std::move(kw), ""};
+    };
+    const auto & list = [] {
+        return MIR::ObjectMap{{"list", std::make_shared<MIR::String>("a")}};
+    };
+
+    // Too few, too many, and the wrong type of positional arguments
+    EXPECT_THROW(signature(call({}, list())), Util::Exceptions::InvalidArguments);
+    std::vector<MIR::Object> many{std::make_shared<MIR::String>("a"),
+                                  std::make_shared<MIR::Number>(1),
+                                  std::make_shared<MIR::Number>(2)};
+    EXPECT_THROW(signature(call(std::move(many), list())), Util::Exceptions::InvalidArguments);
+    EXPECT_THROW(signature(call({std::make_shared<MIR::Number>(1)}, list())),
+                 Util::Exceptions::InvalidArguments);
+
+    // A missing required keyword, and a keyword of the wrong type
+    EXPECT_THROW(signature(call({std::make_shared<MIR::String>("a")}, {})),
+                 Util::Exceptions::InvalidArguments);
+    auto kw = list();
+    kw["flag"] = std::make_shared<MIR::String>("true");
+    EXPECT_THROW(signature(call({std::make_shared<MIR::String>("a")}, std::move(kw))),
+                 Util::Exceptions::InvalidArguments);
+}
+
+TEST(signature, variadic_min) {
+    constexpr Signature sources{
+        Positional<MIR::StringPtr>{},
+        Variadic<MIR::StringPtr>{1},
+    };
+    std::vector<MIR::Object> one{std::make_shared<MIR::String>("name")};
+    EXPECT_THROW(sources(MIR::FunctionCall{"func", std::move(one), ""}),
+                 Util::Exceptions::InvalidArguments);
+
+    // Arrays are flattened after the count is checked, so an empty one counts
+    std::vector<MIR::Object> two{std::make_shared<MIR::String>("name"),
+                                 std::make_shared<MIR::Array>()};
+    const auto & [name, srcs] = sources(MIR::FunctionCall{"func", std::move(two), ""});
+    EXPECT_EQ(name->value, "name");
+    EXPECT_TRUE(srcs.empty());
+}
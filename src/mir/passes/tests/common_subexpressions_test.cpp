@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+#include <gtest/gtest.h>
+
+#include "passes.hpp"
+#include "passes/private.hpp"
+
+#include "test_utils.hpp"
+
+namespace {
+
+void run(const std::shared_ptr<MIR::CFGNode> & irlist) {
+    MIR::Passes::graph_walker(irlist, {MIR::Passes::GlobalValueNumbering{}});
+    MIR::Passes::graph_walker(irlist, {MIR::Passes::CommonSubexpressions{}});
+}
+
+} // namespace
+
+TEST(common_subexpressions, simple) {
+    auto irlist = lower(R"EOF(
+        x = find_program('python3')
+        y = find_program('python3')
+        z = find_program('python3', required : false)
+        )EOF");
+    run(irlist);
+
+    auto it = irlist->block->instructions.begin();
+    ASSERT_TRUE(std::holds_alternative<MIR::FunctionCallPtr>(*it));
+
+    ++it;
+    ASSERT_TRUE(std::holds_alternative<MIR::IdentifierPtr>(*it));
+    const auto & id = std::get<MIR::IdentifierPtr>(*it);
+    EXPECT_EQ(id->value, "x");
+    EXPECT_EQ(id->version, 1);
+    EXPECT_EQ(id->var.name, "y");
+
+    // Different arguments are a different call
+    ++it;
+    EXPECT_TRUE(std::holds_alternative<MIR::FunctionCallPtr>(*it));
+}
+
+TEST(common_subexpressions, nested) {
+    auto irlist = lower(R"EOF(
+        x = include_directories('inc')
+        executable('exe', 'source.c', include_directories : include_directories('inc'))
+        )EOF");
+    run(irlist);
+
+    const auto & exe = std::get<MIR::FunctionCallPtr>(irlist->block->instructions.back());
+    const auto & inc = exe->kw_args.at("include_directories");
+    ASSERT_TRUE(std::holds_alternative<MIR::IdentifierPtr>(inc));
+    EXPECT_EQ(std::get<MIR::IdentifierPtr>(inc)->value, "x");
+
+    // Targets have side effects, and are never replaced
+    EXPECT_EQ(exe->name, "executable");
+}
+
+TEST(common_subexpressions, not_dominated) {
+    auto irlist = lower(R"EOF(
+        if true
+            x = find_program('python3')
+        else
+            y = find_program('python3')
+        endif
+        z = find_program('python3')
+        )EOF");
+    run(irlist);
+
+    const auto & branch = std::get<MIR::BranchPtr>(irlist->block->instructions.back());
+    const auto & arm2 = std::get<1>(branch->branches.at(1));
+    EXPECT_TRUE(std::holds_alternative<MIR::FunctionCallPtr>(arm2->block->instructions.front()));
+
+    const auto & fin = std::get<MIR::JumpPtr>(arm2->block->instructions.back())->target;
+    EXPECT_TRUE(std::holds_alternative<MIR::FunctionCallPtr>(fin->block->instructions.back()));
+}
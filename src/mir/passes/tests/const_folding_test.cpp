@@ -37,6 +37,26 @@ TEST(constant_folding, simple) {
     ASSERT_EQ(id->version, 1);
 }
 
+TEST(constant_folding, chain) {
+    auto irlist = lower(R"EOF(
+        x = 9
+        y = x
+        z = y
+        w = z
+        message(w)
+        )EOF");
+
+    MIR::Passes::graph_walker(irlist, {
+                                          MIR::Passes::GlobalValueNumbering{},
+                                          MIR::Passes::ConstantFolding{},
+                                      });
+
+    const auto & func = std::get<MIR::FunctionCallPtr>(irlist->block->instructions.back());
+    const auto & id = std::get<MIR::IdentifierPtr>(func->pos_args.front());
+    ASSERT_EQ(id->value, "x");
+    ASSERT_EQ(id->version, 1);
+}
+
 TEST(constant_folding, with_phi) {
     auto irlist = lower(R"EOF(
         if true
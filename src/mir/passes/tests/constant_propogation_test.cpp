@@ -184,3 +184,92 @@ TEST(constant_propogation, into_function_call) {
     const auto & f = std::get<MIR::FunctionCallPtr>(back);
     ASSERT_TRUE(std::holds_alternative<MIR::BooleanPtr>(f->pos_args[0]));
 }
+
+TEST(constant_propogation, pending_uses) {
+    auto irlist = lower(R"EOF(
+        x = find_program('sh')
+        if some_func()
+            message(x)
+        endif
+        )EOF");
+    MIR::Passes::graph_walker(irlist, {MIR::Passes::GlobalValueNumbering{}});
+
+    MIR::Passes::ConstantPropagation pass{};
+    EXPECT_FALSE(MIR::Passes::graph_walker(irlist, {std::ref(pass)}));
+
+    // Stand in for the definition being lowered
+    auto & def = irlist->block->instructions.front();
+    MIR::Object str = std::make_shared<MIR::String>("sh");
+    MIR::set_var(def, str);
+    def = str;
+
+    // Walking just the block with the definition should rewrite the use in
+    // the other block
+    EXPECT_TRUE(pass(irlist));
+
+    const auto & branches = std::get<MIR::BranchPtr>(irlist->block->instructions.back());
+    const auto & arm = std::get<1>(branches->branches.at(0));
+    const auto & msg = std::get<MIR::FunctionCallPtr>(arm->block->instructions.front());
+    ASSERT_TRUE(std::holds_alternative<MIR::StringPtr>(msg->pos_args.at(0)));
+    EXPECT_EQ(std::get<MIR::StringPtr>(msg->pos_args.at(0))->value, "sh");
+}
+
+TEST(constant_propogation, replaced_pending_use) {
+    auto irlist = lower(R"EOF(
+        x = find_program('sh')
+        if some_func()
+            message(x)
+        endif
+        )EOF");
+    MIR::Passes::graph_walker(irlist, {MIR::Passes::GlobalValueNumbering{}});
+
+    MIR::Passes::ConstantPropagation pass{};
+    EXPECT_FALSE(MIR::Passes::graph_walker(irlist, {std::ref(pass)}));
+
+    // Replace the instruction holding the use, as another pass might
+    const auto & branches = std::get<MIR::BranchPtr>(irlist->block->instructions.back());
+    const auto & arm = std::get<1>(branches->branches.at(0));
+    auto & use = arm->block->instructions.front();
+    const auto old = std::get<MIR::FunctionCallPtr>(use);
+    use = std::make_shared<MIR::String>("replaced");
+
+    auto & def = irlist->block->instructions.front();
+    MIR::Object str = std::make_shared<MIR::String>("sh");
+    MIR::set_var(def, str);
+    def = str;
+
+    // The replaced instruction is not rewritten, and is not counted as progress
+    EXPECT_FALSE(pass(irlist));
+    EXPECT_TRUE(std::holds_alternative<MIR::IdentifierPtr>(old->pos_args.at(0)));
+}
+
+TEST(constant_propogation, pending_uses_dropped) {
+    auto irlist = lower(R"EOF(
+        x = find_program('sh')
+        if some_func()
+            message(x)
+        endif
+        )EOF");
+    MIR::Passes::graph_walker(irlist, {MIR::Passes::GlobalValueNumbering{}});
+
+    MIR::Passes::ConstantPropagation pass{};
+    EXPECT_FALSE(MIR::Passes::graph_walker(irlist, {std::ref(pass)}));
+
+    // Seeing the definition again, still not propagatable, drops the use
+    EXPECT_FALSE(pass(irlist));
+
+    auto & def = irlist->block->instructions.front();
+    MIR::Object str = std::make_shared<MIR::String>("sh");
+    MIR::set_var(def, str);
+    def = str;
+
+    const auto & branches = std::get<MIR::BranchPtr>(irlist->block->instructions.back());
+    const auto & arm = std::get<1>(branches->branches.at(0));
+    const auto & use = std::get<MIR::FunctionCallPtr>(arm->block->instructions.front());
+    EXPECT_FALSE(pass(irlist));
+    EXPECT_TRUE(std::holds_alternative<MIR::IdentifierPtr>(use->pos_args.at(0)));
+
+    // It is found again when the block using it is walked
+    EXPECT_TRUE(pass(arm));
+    EXPECT_TRUE(std::holds_alternative<MIR::StringPtr>(use->pos_args.at(0)));
+}
@@ -127,3 +127,55 @@ TEST(insert_phi, nested_branches) {
         EXPECT_EQ(phi->right, 4);
     }
 }
+
+TEST(insert_phi, dominators) {
+    auto irlist = lower(R"EOF(
+        if true
+            x = 9
+        else
+            x = 10
+        endif
+        )EOF");
+
+    const MIR::Passes::DominatorTree dom{irlist};
+    ASSERT_EQ(dom.order.size(), 4);
+    EXPECT_EQ(dom.order.front(), irlist);
+
+    const auto & branch = std::get<MIR::BranchPtr>(irlist->block->instructions.back());
+    const auto & arm1 = std::get<1>(branch->branches.at(0));
+    const auto & arm2 = std::get<1>(branch->branches.at(1));
+    const auto & fin = std::get<MIR::JumpPtr>(arm1->block->instructions.back())->target;
+
+    // Every block is dominated by the entry, including the join
+    EXPECT_EQ(dom.idom.at(arm1->index), irlist->index);
+    EXPECT_EQ(dom.idom.at(arm2->index), irlist->index);
+    EXPECT_EQ(dom.idom.at(fin->index), irlist->index);
+
+    // The join is where each arm stops dominating
+    EXPECT_EQ(dom.frontier.at(arm1->index), std::vector<uint32_t>{fin->index});
+    EXPECT_EQ(dom.frontier.at(arm2->index), std::vector<uint32_t>{fin->index});
+    EXPECT_EQ(dom.frontier.count(irlist->index), 0);
+    EXPECT_EQ(dom.frontier.count(fin->index), 0);
+}
+
+TEST(insert_phi, one_arm) {
+    auto irlist = lower(R"EOF(
+        x = 1
+        y = 2
+        if true
+            x = 9
+        endif
+        )EOF");
+    MIR::Passes::graph_walker(irlist, {MIR::Passes::GlobalValueNumbering{}});
+
+    const auto & branch = std::get<MIR::BranchPtr>(irlist->block->instructions.back());
+    const auto & arm1 = std::get<1>(branch->branches.at(0));
+    const auto & fin = std::get<MIR::JumpPtr>(arm1->block->instructions.back())->target;
+
+    // Only x is assigned in the arm, so only x needs a phi
+    ASSERT_EQ(fin->block->instructions.size(), 1);
+    const MIR::Object & instr = fin->block->instructions.front();
+    ASSERT_TRUE(std::holds_alternative<MIR::PhiPtr>(instr));
+    const MIR::Variable & var = std::visit(MIR::VariableGetter{}, instr);
+    EXPECT_EQ(var.name, "x");
+}
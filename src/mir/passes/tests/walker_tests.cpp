@@ -59,3 +59,156 @@ TEST(graph_walker, predecessors_first) {
     const auto & last = std::get<MIR::JumpPtr>((*s)->block->instructions.back())->target;
     EXPECT_EQ(seen[3], last->index);
 }
+
+TEST(graph_walker, cached_order) {
+    const auto node = lower(R"EOF(
+        a = 0
+        if true
+            a = 1
+        else
+            a = 2
+        endif
+        a = 3
+        )EOF");
+    const auto then_block = *node->successors.begin();
+    const auto & else_block = *std::next(node->successors.begin());
+    const auto & last = std::get<MIR::JumpPtr>(else_block->block->instructions.back())->target;
+
+    const auto cfg = MIR::Passes::CFGAnalysis::get(node);
+    ASSERT_EQ(cfg->order.size(), 4);
+    EXPECT_EQ(cfg->position[last->index], 3);
+    const auto [first, end] = cfg->predecessors(3);
+    EXPECT_EQ(std::vector<uint32_t>(first, end), (std::vector<uint32_t>{1, 2}));
+
+    // Nothing has changed, so the same analysis is used
+    EXPECT_EQ(MIR::Passes::CFGAnalysis::get(node), cfg);
+
+    // Removing a block while walking is picked up by the rest of the walk
+    std::vector<uint32_t> seen;
+    MIR::Passes::graph_walker(node, {[&](const std::shared_ptr<MIR::CFGNode> & b) {
+                                  seen.emplace_back(b->index);
+                                  if (b == node) {
+                                      MIR::unlink_nodes(node, then_block, false);
+                                      return true;
+                                  }
+                                  return false;
+                              }});
+    EXPECT_TRUE(cfg->stale());
+    EXPECT_EQ(seen, (std::vector<uint32_t>{node->index, else_block->index}));
+
+    // And the next walk recalculates the order
+    const auto recalculated = MIR::Passes::CFGAnalysis::get(node);
+    EXPECT_NE(recalculated, cfg);
+    EXPECT_EQ(recalculated->order.size(), 2);
+}
+
+TEST(pass_manager, revisit_changed) {
+    std::vector<uint32_t> seen;
+    const auto node = lower(R"EOF(
+        a = 0
+        if true
+            a = 1
+        else
+            a = 2
+        endif
+        a = 3
+        )EOF");
+    const auto & then_block = *node->successors.begin();
+    const auto & else_block = *std::next(node->successors.begin());
+    const auto & last = std::get<MIR::JumpPtr>(else_block->block->instructions.back())->target;
+
+    // Make progress on the else block the first two times it is walked
+    uint32_t pending = 2;
+    auto && tester = [&](const std::shared_ptr<MIR::CFGNode> & b) -> bool {
+        seen.emplace_back(b->index);
+        if (b == else_block && pending > 0) {
+            --pending;
+            return true;
+        }
+        return false;
+    };
+
+    MIR::Passes::PassManager pm{{tester}};
+    ASSERT_TRUE(pm(node));
+    ASSERT_EQ(seen.size(), 4);
+    EXPECT_EQ(seen[3], last->index);
+
+    // Only the block that made progress, and the blocks reachable from it,
+    // should be walked again
+    seen.clear();
+    ASSERT_TRUE(pm(node));
+    ASSERT_EQ(seen.size(), 2);
+    EXPECT_EQ(seen[0], else_block->index);
+    EXPECT_EQ(seen[1], last->index);
+
+    // The blocks reachable from the one that made progress were walked after
+    // it changed, so only it needs to be walked again
+    seen.clear();
+    ASSERT_FALSE(pm(node));
+    ASSERT_EQ(seen.size(), 1);
+    EXPECT_EQ(seen[0], else_block->index);
+
+    seen.clear();
+    ASSERT_FALSE(pm(node));
+    EXPECT_TRUE(seen.empty());
+
+    pm.invalidate();
+    ASSERT_FALSE(pm(node));
+    ASSERT_EQ(seen.size(), 4);
+    EXPECT_EQ(seen[0], node->index);
+    EXPECT_EQ(seen[1], then_block->index);
+}
+
+TEST(instruction_walker, object_mask) {
+    auto irlist = lower("x = ['a', 1, ['b', true]]");
+
+    uint32_t strings = 0;
+    uint32_t everything = 0;
+    MIR::Passes::instruction_walker(
+        *irlist, {
+                     {[&](const MIR::Object & obj) -> std::optional<MIR::Object> {
+                          EXPECT_TRUE(std::holds_alternative<MIR::StringPtr>(obj));
+                          ++strings;
+                          return std::nullopt;
+                      },
+                      MIR::Passes::object_mask<MIR::StringPtr>()},
+                     [&](const MIR::Object &) -> std::optional<MIR::Object> {
+                         ++everything;
+                         return std::nullopt;
+                     },
+                 });
+
+    EXPECT_EQ(strings, 2);
+    EXPECT_EQ(everything, 6);
+}
+
+TEST(instruction_walker, reduced_after_replacement) {
+    auto irlist = lower("f(['a', x], y : [x])");
+    const auto & f = std::get<MIR::FunctionCallPtr>(irlist->block->instructions.front());
+    const auto & arr = std::get<MIR::ArrayPtr>(f->pos_args.front());
+    EXPECT_FALSE(f->args_reduced());
+    EXPECT_FALSE(arr->is_reduced());
+
+    const auto & replace = [](std::string_view name, MIR::Object with) {
+        return [name, with](const MIR::Object & obj) -> std::optional<MIR::Object> {
+            if (std::get<MIR::IdentifierPtr>(obj)->value == name) {
+                return with;
+            }
+            return std::nullopt;
+        };
+    };
+
+    MIR::Passes::instruction_walker(
+        *irlist, {{replace("x", std::make_shared<MIR::String>("b")),
+                   MIR::Passes::object_mask<MIR::IdentifierPtr>()}});
+    EXPECT_TRUE(arr->is_reduced());
+    EXPECT_TRUE(f->args_reduced());
+
+    // Replacing a reduced value with one that is not has to be noticed too
+    arr->value.back() = std::make_shared<MIR::Identifier>("z");
+    MIR::Passes::instruction_walker(
+        *irlist, {{replace("z", std::make_shared<MIR::Identifier>("w")),
+                   MIR::Passes::object_mask<MIR::IdentifierPtr>()}});
+    EXPECT_FALSE(arr->is_reduced());
+    EXPECT_FALSE(f->args_reduced());
+}
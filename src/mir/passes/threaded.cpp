@@ -6,6 +6,7 @@
 #include "log.hpp"
 #include "passes.hpp"
 #include "private.hpp"
+#include "trace.hpp"
 
 #include <algorithm>
 #include <array>
@@ -104,13 +105,21 @@ class FindList {
     }
 };
 
+constexpr Signature find_program_args{
+    Positional<StringPtr>{},
+    Variadic<StringPtr>{},
+    Keyword<BooleanPtr>{"required"},
+};
+
 bool search_find_program(const FunctionCallPtr & f, State::Persistant & pstate, FindList & jobs) {
-    auto names = extract_variadic_arguments<StringPtr>(f->pos_args.begin(), f->pos_args.end(),
-                                                       "find_program: names must be strings");
+    const auto & args = find_program_args(*f);
+    const auto & names = std::get<1>(args);
 
-    std::vector<std::string> ret{names.size()};
-    std::transform(names.begin(), names.end(), ret.begin(),
-                   [](const StringPtr & s) { return s->value; });
+    std::vector<std::string> ret{std::get<0>(args)->value};
+    ret.reserve(names.size() + 1);
+    for (const auto & n : names) {
+        ret.emplace_back(n->value);
+    }
     jobs.emplace(Type::PROGRAM, std::move(ret));
 
     return true;
@@ -118,12 +127,14 @@ bool search_find_program(const FunctionCallPtr & f, State::Persistant & pstate,
 
 void worker(FindList & jobs, std::mutex & state_lock, State::Persistant & pstate,
             std::set<std::string> & programs) {
+    Util::Trace::set_thread_name("find_program");
     while (true) {
         auto got = jobs.get();
         if (!got) {
             return;
         }
         auto [job, names] = got.value();
+        Util::Trace::Scope trace{"mir", [&n = names] { return "find_program " + n[0]; }};
 
         switch (job) {
             case Type::PROGRAM:
@@ -160,11 +171,9 @@ void search_for_threaded_impl(FindList & jobs, State::Persistant & pstate) {
 }
 
 std::optional<Object> replace_find_program(const FunctionCallPtr & f, State::Persistant & state) {
-    // We know this is safe since we've already processed this call before (hopefully)
     // We only need the first name, as all of the names should be in the mapping
-    auto name = extract_positional_argument<StringPtr>(
-                    f->pos_args[0], f->name + ": first argument was not a string")
-                    ->value;
+    const auto & [first, _, raw_required] = find_program_args(*f);
+    const std::string & name = first->value;
 
     fs::path exe;
     try {
@@ -173,11 +182,7 @@ std::optional<Object> replace_find_program(const FunctionCallPtr & f, State::Per
         exe = "";
     }
 
-    bool required =
-        extract_keyword_argument<BooleanPtr>(
-            f->kw_args, "required", "find_program: 'required' keyword argument must be a boolean")
-            .value_or(std::make_shared<Boolean>(true))
-            ->value;
+    const bool required = !raw_required || raw_required.value()->value;
     if (required && exe == "") {
         throw Util::Exceptions::MesonException("Could not find required program \"" + name + "\"");
     }
@@ -194,11 +199,11 @@ bool search_threaded(const Object & obj, State::Persistant & pstate, FindList &
     if (f->holder) {
         return false;
     }
-    if (!all_args_reduced(f->pos_args, f->kw_args)) {
+    if (!f->args_reduced()) {
         return false;
     }
 
-    if (f->name == "find_program") {
+    if (f->id == Builtin::FIND_PROGRAM) {
         return search_find_program(f, pstate, jobs);
     }
     return false;
@@ -213,12 +218,12 @@ std::optional<Object> replace_threaded(const Object & obj, State::Persistant & s
     if (f->holder) {
         return std::nullopt;
     }
-    if (!all_args_reduced(f->pos_args, f->kw_args)) {
+    if (!f->args_reduced()) {
         return std::nullopt;
     }
 
     std::optional<Object> i{std::nullopt};
-    if (f->name == "find_program") {
+    if (f->id == Builtin::FIND_PROGRAM) {
         i = replace_find_program(f, state);
     }
 
@@ -232,6 +237,12 @@ std::optional<Object> replace_threaded(const Object & obj, State::Persistant & s
 } // namespace
 
 bool threaded_lowering(std::shared_ptr<CFGNode> block, State::Persistant & pstate) {
+    PassTimer timer{false};
+    return threaded_lowering(std::move(block), pstate, timer);
+}
+
+bool threaded_lowering(std::shared_ptr<CFGNode> block, State::Persistant & pstate,
+                       PassTimer & timer) {
     bool progress = false;
     FindList jobs{};
 
@@ -239,23 +250,22 @@ bool threaded_lowering(std::shared_ptr<CFGNode> block, State::Persistant & pstat
     //  1. call the block walker to gather find_program, dependency, etc
     //  2. create the threads and send them to work on filling out those futures
     //  3. call the block walker again to fill in those values
-    progress |= graph_walker(block, {
-                                        [&](std::shared_ptr<CFGNode> b) {
-                                            return instruction_walker(*b, {[&](const Object & obj) {
-                                                return search_threaded(obj, pstate, jobs);
-                                            }});
-                                        },
-                                    });
+    const auto & search = [&](const std::shared_ptr<CFGNode> & b) {
+        return instruction_walker(
+            *b, {[&](const Object & obj) { return search_threaded(obj, pstate, jobs); }});
+    };
+    const auto & replace = [&](const std::shared_ptr<CFGNode> & b) {
+        return instruction_walker(
+            *b, {[&](const Object & obj) { return replace_threaded(obj, pstate); }});
+    };
+
+    progress |= graph_walker(block, {timer.wrap("threaded_lowering: search", search)});
     if (progress) {
-        search_for_threaded_impl(jobs, pstate);
-        progress |=
-            graph_walker(block, {
-                                    [&](std::shared_ptr<CFGNode> b) {
-                                        return instruction_walker(*b, {[&](const Object & obj) {
-                                            return replace_threaded(obj, pstate);
-                                        }});
-                                    },
-                                });
+        {
+            PassTimer::Scope scope{timer, "threaded_lowering: find"};
+            search_for_threaded_impl(jobs, pstate);
+        }
+        progress |= graph_walker(block, {timer.wrap("threaded_lowering: replace", replace)});
     }
     return progress;
 }
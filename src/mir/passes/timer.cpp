@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "passes.hpp"
+
+namespace MIR::Passes {
+
+namespace {
+
+void print_header(std::ostream & out, const std::string & name) {
+    out << "  " << std::left << std::setw(36) << name << std::right << std::setw(10) << "calls"
+        << std::setw(14) << "instructions" << std::setw(10) << "progress" << std::setw(12)
+        << "time (ms)" << "\n";
+}
+
+template <typename T>
+void print_row(std::ostream & out, const std::string & name, const T & stats) {
+    out << "  " << std::left << std::setw(36) << name << std::right << std::setw(10)
+        << stats.calls << std::setw(14) << stats.instructions << std::setw(10) << stats.progress
+        << std::setw(12) << std::fixed << std::setprecision(3)
+        << std::chrono::duration<double, std::milli>(stats.time).count() << "\n";
+}
+
+} // namespace
+
+PassTimer::PassTimer() : enabled{std::getenv("MESONPP_TIME_PASSES") != nullptr} {}
+
+PassTimer::PassTimer(bool enabled_) : enabled{enabled_} {}
+
+PassTimer::~PassTimer() {
+    if (!enabled) {
+        return;
+    }
+
+    Stats total{"total"};
+    for (const auto & s : passes) {
+        total.time += s.time;
+        total.calls += s.calls;
+        total.instructions += s.instructions;
+        total.progress += s.progress;
+    }
+
+    std::ostream & out = std::cerr;
+    out << "MIR pass timing:\n";
+    print_header(out, "pass");
+    for (const auto & s : passes) {
+        print_row(out, s.name, s);
+    }
+    print_row(out, total.name, total);
+
+    out << "MIR iterations:\n";
+    print_header(out, "iteration");
+    for (size_t i = 0; i < iterations.size(); ++i) {
+        print_row(out, std::to_string(i + 1) + " (" + iterations[i].name + ")", iterations[i]);
+    }
+    out << std::flush;
+}
+
+size_t PassTimer::find(std::string name) {
+    auto it = std::find_if(passes.begin(), passes.end(),
+                           [&name](const Stats & s) { return s.name == name; });
+    if (it != passes.end()) {
+        return std::distance(passes.begin(), it);
+    }
+    passes.emplace_back(Stats{std::move(name)});
+    return passes.size() - 1;
+}
+
+void PassTimer::record(size_t index, Clock::duration time, uint64_t instructions,
+                       bool progress) {
+    const auto & update = [&](Stats & s) {
+        s.time += time;
+        s.calls++;
+        s.instructions += instructions;
+        s.progress += progress;
+    };
+    update(passes[index]);
+    if (!iterations.empty()) {
+        update(iterations.back());
+    }
+}
+
+PassTimer::BlockPass PassTimer::wrap(std::string name, BlockPass pass) {
+    // When disabled hand the pass back untouched, so there is no overhead
+    if (!enabled) {
+        return pass;
+    }
+
+    const size_t index = find(std::move(name));
+    return [this, index, pass = std::move(pass)](const std::shared_ptr<CFGNode> & block) {
+        const uint64_t instructions = block->block->instructions.size();
+        const auto start = Clock::now();
+        const bool progress = pass(block);
+        record(index, Clock::now() - start, instructions, progress);
+        return progress;
+    };
+}
+
+void PassTimer::iteration(std::string phase) {
+    if (enabled) {
+        iterations.emplace_back(Stats{std::move(phase)});
+    }
+}
+
+PassTimer::Scope::Scope(PassTimer & t, std::string name)
+    : timer{t}, index{t.enabled ? t.find(std::move(name)) : 0},
+      start{t.enabled ? Clock::now() : Clock::time_point{}} {}
+
+PassTimer::Scope::~Scope() {
+    if (timer.enabled) {
+        timer.record(index, Clock::now() - start, 0, false);
+    }
+}
+
+} // namespace MIR::Passes
@@ -7,80 +7,136 @@
 
 #include <algorithm>
 #include <cassert>
-#include <stdexcept>
-#include <tuple>
+#include <iterator>
+#include <unordered_set>
 
 namespace MIR::Passes {
 
-bool GlobalValueNumbering::insert_phis(CFGNode & b) {
-    // Merge the data down, even for strictly dominated blocks
-    for (auto && r : b.predecessors) {
-        auto p = r.lock();
-        for (auto && [var, value] : data[p->index]) {
-            if (data[b.index].find(var) == data[b.index].end()) {
-                data[b.index][var] = value;
-            } else {
-                data[b.index][var] = std::max(data[b.index][var], value);
+void GlobalValueNumbering::place_phis() {
+    // Every block that defines each variable
+    std::unordered_map<Symbol, std::vector<uint32_t>> defs;
+    for (const auto & b : dominators->order) {
+        for (const auto & i : b->block->instructions) {
+            if (const auto & var = std::visit(VariableGetter{}, i)) {
+                auto & sites = defs[var.name];
+                if (sites.empty() || sites.back() != b->index) {
+                    sites.emplace_back(b->index);
+                }
             }
         }
     }
 
-    if (b.predecessors.size() <= 1) {
-        return false;
+    // A phi is a definition too, so phis are placed on the iterated
+    // dominance frontier of the definitions
+    for (auto && [name, work] : defs) {
+        std::unordered_set<uint32_t> placed{};
+        while (!work.empty()) {
+            const uint32_t b = work.back();
+            work.pop_back();
+            if (auto f = dominators->frontier.find(b); f != dominators->frontier.end()) {
+                for (const uint32_t d : f->second) {
+                    if (placed.emplace(d).second) {
+                        phis[d].emplace_back(name);
+                        work.emplace_back(d);
+                    }
+                }
+            }
+        }
     }
 
-    // Calculate all variables that have convergence
-    //
-    // This is true if a variable is present in at least two predecessors
-    std::vector<std::tuple<std::string, std::vector<uint32_t>>> convergence{};
-    for (auto && [var, _] : data[b.index]) {
-        std::vector<uint32_t> values;
-        for (auto && r : b.predecessors) {
-            auto p = r.lock();
-            if (auto && i = data[p->index].find(var); i != data[p->index].end()) {
-                values.emplace_back(i->second);
+    // Keep the order of the phis stable
+    for (auto && [_, names] : phis) {
+        std::sort(names.begin(), names.end(),
+                  [](const Symbol & l, const Symbol & r) { return l.id() < r.id(); });
+    }
+}
+
+uint32_t GlobalValueNumbering::lookup(const Symbol & name, uint32_t block) const {
+    // If a block doesn't define a variable (and doesn't have a phi for it),
+    // then it has the same version as at the end of the immediate dominator
+    while (true) {
+        if (const auto d = data.find(block); d != data.end()) {
+            if (const auto v = d->second.find(name); v != d->second.end()) {
+                return v->second;
             }
         }
-        if (values.size() >= 2) {
-            convergence.emplace_back(std::make_tuple(var, std::move(values)));
+        const auto dom = dominators->idom.find(block);
+        if (dom == dominators->idom.end() || dom->second == block) {
+            return 0;
         }
+        block = dom->second;
     }
+}
 
-    if (convergence.empty()) {
+uint32_t GlobalValueNumbering::next_version(const Symbol & name) {
+    if (name.id() >= gvn.size()) {
+        gvn.resize(Symbol::count());
+    }
+    return ++gvn[name.id()];
+}
+
+bool GlobalValueNumbering::insert_phis(CFGNode & b) {
+    const auto candidates = phis.find(b.index);
+    if (candidates == phis.end()) {
         return false;
     }
 
-    std::list<Object> phis;
-    for (auto && [var, values] : convergence) {
+    std::vector<Object> new_phis;
+    for (const Symbol & name : candidates->second) {
+        // The version reaching the end of each predecessor, in predecessor order
+        std::vector<uint32_t> values;
+        for (auto && r : b.predecessors) {
+            if (const uint32_t v = lookup(name, r.lock()->index)) {
+                values.emplace_back(v);
+            }
+        }
+
+        if (values.empty()) {
+            continue;
+        }
+
+        // If only one version reaches this block there is nothing to merge,
+        // that version is just live here
+        if (std::all_of(values.begin(), values.end(),
+                        [&](const uint32_t v) { return v == values.front(); })) {
+            data[b.index][name] = values.front();
+            continue;
+        }
+
+        // Phis only have two operands, so chain them together to merge more
         auto it = values.begin();
-        uint32_t cur = ++data[b.index][var];
         uint32_t prev = *it++;
         for (; it != values.end(); ++it) {
             auto phi = std::make_shared<Phi>(prev, *it);
-            phi->var = Variable{var, cur};
-            phis.emplace_back(phi);
-            prev = cur++;
+            prev = next_version(name);
+            phi->var = Variable{name, prev};
+            new_phis.emplace_back(phi);
         }
+        data[b.index][name] = prev;
     }
 
-    b.block->instructions.splice(b.block->instructions.begin(), phis);
+    if (new_phis.empty()) {
+        return false;
+    }
+
+    b.block->instructions.insert(b.block->instructions.begin(),
+                                 std::make_move_iterator(new_phis.begin()),
+                                 std::make_move_iterator(new_phis.end()));
 
     return true;
 };
 
 bool GlobalValueNumbering::number(Object & obj, const uint32_t block_index) {
     bool progress = false;
-    std::unordered_map<std::string, uint32_t> & table = data[block_index];
 
     if (std::holds_alternative<IdentifierPtr>(obj)) {
         auto & id = std::get<IdentifierPtr>(obj);
         // TODO: use before definition
         if (!id->version) {
-            try {
-                id->version = table.at(id->value);
-            } catch (std::out_of_range &) {
-                throw Util::Exceptions::MesonException{"Attempted to use variable '" + id->value +
-                                                       "' before it's definition"};
+            id->version = lookup(id->value, block_index);
+            if (!id->version) {
+                throw Util::Exceptions::MesonException{"Attempted to use variable '" +
+                                                       id->value.str() + "' before it's definition"};
             }
             progress = true;
         }
@@ -90,15 +146,21 @@ bool GlobalValueNumbering::number(Object & obj, const uint32_t block_index) {
     // function arguments, which might otherwise create a circular reference
     MIR::Variable & var = std::visit(VariableGetter{}, obj);
     if (var && var.gvn == 0) {
-        var.gvn = ++gvn[var.name];
-        table[var.name] = var.gvn;
+        var.gvn = next_version(var.name);
+        data[block_index][var.name] = var.gvn;
         progress = true;
     }
 
     return progress;
 }
 
-bool GlobalValueNumbering::operator()(std::shared_ptr<CFGNode> block) {
+bool GlobalValueNumbering::operator()(const std::shared_ptr<CFGNode> & block) {
+    // The first block walked is the root of the graph
+    if (!dominators) {
+        dominators.emplace(block);
+        place_phis();
+    }
+
     // Don't run this pass on the same data twice
     if (data.find(block->index) != data.end()) {
         return false;
@@ -5,9 +5,12 @@
 #include "private.hpp"
 
 #include <algorithm>
+#include <cassert>
 #include <deque>
 #include <set>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace MIR::Passes {
 
@@ -17,28 +20,52 @@ class BlockIterator {
   private:
     std::shared_ptr<CFGNode> current;
     std::deque<std::weak_ptr<CFGNode>> todo;
-    std::set<uint32_t> seen;
 
-    void add_todo(std::shared_ptr<CFGNode> b) {
-        if (b && !block_worked(b->index) && all_predecessors_seen(b)) {
+    /**
+     * Which blocks have been worked, indexed by CFGNode::index
+     *
+     * Block indexes are small and dense, so this is much cheaper to query
+     * than a tree based set.
+     */
+    std::vector<bool> seen;
+
+    void add_todo(const std::shared_ptr<CFGNode> & b) {
+        if (b && !block_worked(b->index) && all_predecessors_seen(*b)) {
             todo.emplace_front(b);
         }
     }
 
-    bool all_predecessors_seen(const std::shared_ptr<CFGNode> b) const {
+    bool all_predecessors_seen(const CFGNode & b) const {
         return std::all_of(
-            b->predecessors.begin(), b->predecessors.end(),
-            [this](const std::weak_ptr<CFGNode> p) { return this->block_worked(p.lock()->index); });
+            b.predecessors.begin(), b.predecessors.end(),
+            [this](const std::weak_ptr<CFGNode> & p) { return block_worked(p.lock()->index); });
     }
 
-    bool block_worked(uint32_t b) const { return seen.find(b) != seen.end(); }
+    bool block_worked(uint32_t b) const { return b < seen.size() && seen[b]; }
 
   public:
-    BlockIterator(std::shared_ptr<CFGNode> c) { add_todo(c); };
+    BlockIterator(const std::shared_ptr<CFGNode> & c) { add_todo(c); };
+
+    /// Pick up a walk of the cached order just after the block at position i was returned
+    BlockIterator(const CFGAnalysis & cfg, uint32_t i) : current{cfg.order[i]} {
+        for (uint32_t j = 0; j <= i; ++j) {
+            const uint32_t index = cfg.order[j]->index;
+            if (index >= seen.size()) {
+                seen.resize(index + 1);
+            }
+            seen[index] = true;
+        }
+        for (uint32_t j = i + 1; j <= i + cfg.queued[i]; ++j) {
+            todo.emplace_front(cfg.order[j]);
+        }
+    }
+
+    /// The number of blocks waiting to be returned
+    size_t pending() const { return todo.size(); }
 
     std::shared_ptr<CFGNode> get() {
         if (current) {
-            for (auto && c : current->successors) {
+            for (const auto & c : current->successors) {
                 add_todo(c);
             }
         }
@@ -48,7 +75,10 @@ class BlockIterator {
             todo.pop_back();
             if (current) {
                 assert(!block_worked(current->index));
-                seen.emplace(current->index);
+                if (current->index >= seen.size()) {
+                    seen.resize(current->index + 1);
+                }
+                seen[current->index] = true;
                 return current;
             }
         }
@@ -56,123 +86,169 @@ class BlockIterator {
     }
 };
 
-bool mutation_visitor(Object & it, MutationCallback cb) {
+std::shared_ptr<const CFGAnalysis> & cached_analysis() {
+    // Graphs are only walked from the main thread, so this is not locked
+    static std::shared_ptr<const CFGAnalysis> cfg;
+    [[maybe_unused]] static const std::thread::id owner = std::this_thread::get_id();
+    assert(std::this_thread::get_id() == owner);
+    return cfg;
+}
+
+/**
+ * Walk the graph from root, calling `visit(block, cfg, position)` on each block
+ *
+ * This follows the cached order, until a callback changes the shape of the
+ * graph. The walk then continues exactly as if it had been following the graph
+ * all along, and `visit` is passed a null cfg.
+ */
+template <typename F> void walk(const std::shared_ptr<CFGNode> & root, F && visit) {
+    std::shared_ptr<const CFGAnalysis> cfg = CFGAnalysis::get(root);
+    for (uint32_t i = 0; i < cfg->order.size(); ++i) {
+        visit(cfg->order[i], cfg.get(), i);
+        if (cfg->stale()) {
+            BlockIterator iter{*cfg, i};
+
+            // Let go of the blocks in the old order, so that any that were
+            // removed from the graph are freed and skipped, as they would
+            // be by the BlockIterator
+            cfg.reset();
+            CFGAnalysis::reset();
+
+            while (std::shared_ptr<CFGNode> current = iter.get()) {
+                visit(current, nullptr, 0);
+            }
+            return;
+        }
+    }
+}
+
+// The walkers below are run for every instruction in every block on each
+// iteration of the lowering loop, so they access the held objects by
+// reference, rather than copying the shared_ptrs, to avoid the atomic
+// reference count updates.
+
+/// Tell an object that holds other objects that they have been changed
+void contents_changed(const Object & obj) {
+    if (const auto * a = std::get_if<MIR::ArrayPtr>(&obj)) {
+        (*a)->changed();
+    } else if (const auto * d = std::get_if<MIR::DictPtr>(&obj)) {
+        (*d)->changed();
+    } else if (const auto * f = std::get_if<MIR::FunctionCallPtr>(&obj)) {
+        (*f)->changed();
+    }
+}
+
+bool mutation_visitor(Object & it, const std::vector<MutationCallback> & cbs) {
     bool progress = false;
 
-    if (std::holds_alternative<MIR::ArrayPtr>(it)) {
-        auto a = std::get<MIR::ArrayPtr>(it);
-        for (auto & a : a->value) {
-            progress |= mutation_visitor(a, cb);
+    if (const auto * a = std::get_if<MIR::ArrayPtr>(&it)) {
+        for (auto & e : (*a)->value) {
+            progress |= mutation_visitor(e, cbs);
         }
-    } else if (std::holds_alternative<MIR::DictPtr>(it)) {
-        auto d = std::get<MIR::DictPtr>(it);
-        for (auto & [_, v] : d->value) {
-            progress |= mutation_visitor(v, cb);
+    } else if (const auto * d = std::get_if<MIR::DictPtr>(&it)) {
+        for (auto && [_, v] : (*d)->value) {
+            progress |= mutation_visitor(v, cbs);
         }
-    } else if (std::holds_alternative<MIR::FunctionCallPtr>(it)) {
-        auto f = std::get<MIR::FunctionCallPtr>(it);
-        for (auto & p : f->pos_args) {
-            progress |= mutation_visitor(p, cb);
+    } else if (const auto * f = std::get_if<MIR::FunctionCallPtr>(&it)) {
+        for (auto & p : (*f)->pos_args) {
+            progress |= mutation_visitor(p, cbs);
         }
-        for (auto & [_, v] : f->kw_args) {
-            progress |= mutation_visitor(v, cb);
+        for (auto && [_, v] : (*f)->kw_args) {
+            progress |= mutation_visitor(v, cbs);
         }
-        if (f->holder) {
-            progress |= mutation_visitor(f->holder.value(), cb);
+        if ((*f)->holder) {
+            progress |= mutation_visitor((*f)->holder.value(), cbs);
         }
-    } else if (std::holds_alternative<MIR::JumpPtr>(it)) {
-        auto j = std::get<MIR::JumpPtr>(it);
-        if (j->predicate) {
-            progress |= mutation_visitor(*j->predicate, cb);
+    } else if (const auto * j = std::get_if<MIR::JumpPtr>(&it)) {
+        if ((*j)->predicate) {
+            progress |= mutation_visitor(*(*j)->predicate, cbs);
         }
-    } else if (std::holds_alternative<MIR::BranchPtr>(it)) {
-        auto b = std::get<MIR::BranchPtr>(it);
-        for (auto & [i, _] : b->branches) {
-            progress |= mutation_visitor(i, cb);
+    } else if (const auto * b = std::get_if<MIR::BranchPtr>(&it)) {
+        for (auto & [i, _] : (*b)->branches) {
+            progress |= mutation_visitor(i, cbs);
         }
     }
-    progress |= cb(it);
+    for (const auto & cb : cbs) {
+        progress |= cb(it);
+    }
+
+    // A callback may have changed this object or one of its children in place
+    if (progress) {
+        contents_changed(it);
+    }
 
     return progress;
 }
 
-std::tuple<bool, std::optional<Object>> replacement_visitor(const Object & it,
-                                                            const ReplacementCallback & cb);
-
-bool replace_elements(std::vector<Object> & vec, const ReplacementCallback & cb) {
+/**
+ * Visit an object and its children, replacing any that the callbacks return a
+ * new object for
+ *
+ * If a callback replaces a node the remaining callbacks are called on the
+ * replacement, but its children are not descended into until the next walk.
+ */
+bool replace_in_place(Object & obj, const std::vector<ReplacementPass> & cbs) {
     bool progress = false;
-    for (auto it = vec.begin(); it != vec.end(); ++it) {
-        auto && [rp, rt] = replacement_visitor(*it, cb);
-        progress |= rp;
-        if (rt.has_value()) {
-            vec[it - vec.begin()] = rt.value();
-            progress |= true;
+
+    if (const auto * a = std::get_if<MIR::ArrayPtr>(&obj)) {
+        for (auto & e : (*a)->value) {
+            progress |= replace_in_place(e, cbs);
+        }
+    } else if (const auto * d = std::get_if<MIR::DictPtr>(&obj)) {
+        // TODO: keys
+        for (auto && [_, v] : (*d)->value) {
+            progress |= replace_in_place(v, cbs);
+        }
+    } else if (const auto * f = std::get_if<MIR::FunctionCallPtr>(&obj)) {
+        for (auto & p : (*f)->pos_args) {
+            progress |= replace_in_place(p, cbs);
+        }
+        for (auto && [_, v] : (*f)->kw_args) {
+            progress |= replace_in_place(v, cbs);
+        }
+        if ((*f)->holder) {
+            progress |= replace_in_place((*f)->holder.value(), cbs);
+        }
+    } else if (const auto * j = std::get_if<MIR::JumpPtr>(&obj)) {
+        if ((*j)->predicate) {
+            progress |= replace_in_place(*(*j)->predicate, cbs);
+        }
+    } else if (const auto * b = std::get_if<MIR::BranchPtr>(&obj)) {
+        for (auto & [i, _] : (*b)->branches) {
+            progress |= replace_in_place(i, cbs);
         }
     }
-    return progress;
-}
 
-bool replace_elements(std::unordered_map<std::string, Object> & map,
-                      const ReplacementCallback & cb) {
-    bool progress = false;
-    for (auto it = map.begin(); it != map.end(); ++it) {
-        auto && [rp, rt] = replacement_visitor(it->second, cb);
-        progress |= rp;
-        if (rt.has_value()) {
-            map[it->first] = rt.value();
-            progress |= true;
+    if (progress) {
+        contents_changed(obj);
+    }
+
+    for (const auto & cb : cbs) {
+        if (!cb.wants(obj)) {
+            continue;
+        }
+        if (auto && rt = cb.callback(obj)) {
+            obj = std::move(rt.value());
+            progress = true;
         }
     }
+
     return progress;
 }
 
-std::tuple<bool, std::optional<Object>> replacement_visitor(const Object & it,
-                                                            const ReplacementCallback & cb) {
-    bool progress{false};
+/// Read a flag from a vector of flags indexed by CFGNode::index, missing flags are false
+bool get_flag(const std::vector<bool> & flags, uint32_t index) {
+    return index < flags.size() && flags[index];
+}
 
-    if (std::holds_alternative<MIR::ArrayPtr>(it)) {
-        auto a = std::get<MIR::ArrayPtr>(it);
-        progress |= replace_elements(a->value, cb);
-    } else if (std::holds_alternative<MIR::DictPtr>(it)) {
-        // TODO: keys
-        auto d = std::get<MIR::DictPtr>(it);
-        progress |= replace_elements(d->value, cb);
-    } else if (std::holds_alternative<MIR::FunctionCallPtr>(it)) {
-        auto f = std::get<MIR::FunctionCallPtr>(it);
-        progress |= replace_elements(f->pos_args, cb);
-        progress |= replace_elements(f->kw_args, cb);
-        if (f->holder) {
-            auto && [rp, rt] = replacement_visitor(f->holder.value(), cb);
-            progress |= rp;
-            if (rt) {
-                f->holder = rt.value();
-            }
-        }
-    } else if (std::holds_alternative<MIR::JumpPtr>(it)) {
-        auto j = std::get<MIR::JumpPtr>(it);
-        if (j->predicate) {
-            auto && [rp, rt] = replacement_visitor(*j->predicate, cb);
-            progress |= rp;
-            if (rt) {
-                j->predicate = rt.value();
-                progress |= true;
-            }
-        }
-    } else if (std::holds_alternative<MIR::BranchPtr>(it)) {
-        auto b = std::get<MIR::BranchPtr>(it);
-        for (auto it2 = b->branches.begin(); it2 != b->branches.end(); ++it2) {
-            auto && [rp, rt] = replacement_visitor(std::get<0>(*it2), cb);
-            progress |= rp;
-            if (rt) {
-                b->branches[it2 - b->branches.begin()] =
-                    std::make_tuple(rt.value(), std::get<1>(*it2));
-                progress |= true;
-            }
+void set_flag(std::vector<bool> & flags, uint32_t index, bool value) {
+    if (index >= flags.size()) {
+        if (!value) {
+            return;
         }
+        flags.resize(index + 1);
     }
-    auto && rt = cb(it);
-    progress |= rt.has_value();
-    return std::make_tuple(progress, rt);
+    flags[index] = value;
 }
 
 } // namespace
@@ -181,41 +257,134 @@ bool instruction_walker(CFGNode & block, const std::vector<MutationCallback> & f
     return instruction_walker(block, fc, {});
 }
 
-bool instruction_walker(CFGNode & block, const std::vector<ReplacementCallback> & rc) {
+bool instruction_walker(CFGNode & block, const std::vector<ReplacementPass> & rc) {
     return instruction_walker(block, {}, rc);
 }
 
+bool instruction_walker(Object & inst, const std::vector<MutationCallback> & fc,
+                        const std::vector<ReplacementPass> & rc) {
+    bool progress = false;
+    if (!rc.empty()) {
+        progress |= replace_in_place(inst, rc);
+    }
+    if (!fc.empty()) {
+        progress |= mutation_visitor(inst, fc);
+    }
+    return progress;
+}
+
 bool instruction_walker(CFGNode & block, const std::vector<MutationCallback> & fc,
-                        const std::vector<ReplacementCallback> & rc) {
+                        const std::vector<ReplacementPass> & rc) {
     bool progress = false;
 
-    for (auto it = block.block->instructions.begin(); it != block.block->instructions.end(); ++it) {
-        for (const auto & cb : rc) {
-            auto && [rp, rt] = replacement_visitor(*it, cb);
-            progress |= rp;
-            if (rt) {
-                it = block.block->instructions.erase(it);
-                it = block.block->instructions.insert(it, rt.value());
-                progress |= true;
-            }
-        }
-        for (const auto & cb : fc) {
-            progress |= mutation_visitor(*it, cb);
-        }
+    for (auto & inst : block.block->instructions) {
+        progress |= instruction_walker(inst, fc, rc);
     }
 
     return progress;
 };
 
+CFGAnalysis::CFGAnalysis(const std::shared_ptr<CFGNode> & root_)
+    : root{root_->index}, epoch{cfg_epoch()} {
+    BlockIterator iter{root_};
+    while (std::shared_ptr<CFGNode> current = iter.get()) {
+        if (current->index >= position.size()) {
+            position.resize(current->index + 1, npos);
+        }
+        position[current->index] = order.size();
+        queued.emplace_back(iter.pending());
+        order.emplace_back(std::move(current));
+    }
+
+    // A block is only walked after all of its predecessors, so each of them
+    // already has a position
+    predecessor_offsets.reserve(order.size() + 1);
+    for (const auto & b : order) {
+        predecessor_offsets.emplace_back(predecessor_list.size());
+        for (const auto & p : b->predecessors) {
+            predecessor_list.emplace_back(position[p.lock()->index]);
+        }
+    }
+    predecessor_offsets.emplace_back(predecessor_list.size());
+}
+
+std::shared_ptr<const CFGAnalysis> CFGAnalysis::get(const std::shared_ptr<CFGNode> & root) {
+    auto & cfg = cached_analysis();
+    if (!cfg || cfg->root != root->index || cfg->stale()) {
+        cfg = std::make_shared<const CFGAnalysis>(root);
+    }
+    return cfg;
+}
+
+void CFGAnalysis::reset() { cached_analysis().reset(); }
+
 bool graph_walker(std::shared_ptr<CFGNode> root, const std::vector<BlockWalkerCb> & callbacks) {
     bool progress = false;
 
-    BlockIterator iter{root};
-    while (std::shared_ptr<CFGNode> current = iter.get()) {
+    walk(root, [&](const std::shared_ptr<CFGNode> & current, const CFGAnalysis *, uint32_t) {
         for (const auto & cb : callbacks) {
             progress |= cb(current);
         }
-    }
+    });
+
+    return progress;
+}
+
+PassManager::PassManager(std::vector<BlockWalkerCb> passes_) : passes{std::move(passes_)} {}
+
+void PassManager::invalidate() { clean.clear(); }
+
+bool PassManager::successors_changed(const CFGNode & block) const {
+    return !std::equal(successors.begin(), successors.end(), block.successors.begin(),
+                       block.successors.end(),
+                       [](const CFGNode * l, const std::shared_ptr<CFGNode> & r) {
+                           return l == r.get();
+                       });
+}
+
+bool PassManager::operator()(const std::shared_ptr<CFGNode> & root) {
+    bool progress = false;
+    // Once the shape of the graph changes every remaining block has to be
+    // walked, as in graph_walker
+    bool reshaped = false;
+    changed.assign(changed.size(), false);
+
+    walk(root, [&](const std::shared_ptr<CFGNode> & current, const CFGAnalysis * cfg,
+                   uint32_t pos) {
+        const uint32_t index = current->index;
+        // Once the graph has been reshaped every block is walked anyway
+        bool inherited = false;
+        if (cfg) {
+            const auto [first, last] = cfg->predecessors(pos);
+            inherited = std::any_of(first, last, [&](uint32_t p) {
+                return get_flag(changed, cfg->order[p]->index);
+            });
+        }
+
+        if (!reshaped && !inherited && get_flag(clean, index)) {
+            return;
+        }
+
+        successors.clear();
+        for (const auto & s : current->successors) {
+            successors.emplace_back(s.get());
+        }
+
+        bool lprogress = false;
+        for (const auto & cb : passes) {
+            lprogress |= cb(current);
+        }
+
+        set_flag(changed, index, lprogress || inherited);
+        set_flag(clean, index, !lprogress);
+        if (lprogress) {
+            progress = true;
+            if (successors_changed(*current)) {
+                reshaped = true;
+                invalidate();
+            }
+        }
+    });
 
     return progress;
 }
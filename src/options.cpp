@@ -40,6 +40,12 @@ Verbs:
                 The source directory to configure, defaults to '.'
             -D, --define
                 Set a Meson built-in or project option
+            --streaming
+                Lower each statement as soon as it is parsed, which uses less
+                memory, but does not parse in parallel or update the AST cache
+            --trace <file>
+                Write a timeline of the configure phases to <file>, in the
+                Chrome trace event format used by chrome://tracing and Perfetto
 
     Test:
         Usage:
@@ -87,6 +93,8 @@ ConfigureOptions get_config_options(int argc, char * argv[]) {
         {"help", no_argument, nullptr, 'h'},
         {"source-dir", required_argument, nullptr, 's'},
         {"define", required_argument, nullptr, 'D'},
+        {"streaming", no_argument, nullptr, 'S'},
+        {"trace", required_argument, nullptr, 'T'},
         {nullptr},
     };
 
@@ -111,6 +119,12 @@ ConfigureOptions get_config_options(int argc, char * argv[]) {
                 conf.options[opt] = value;
                 break;
             }
+            case 'S':
+                conf.streaming = true;
+                break;
+            case 'T':
+                conf.trace = fs::absolute(optarg);
+                break;
             case 'h':
             default:
                 std::cout << usage << std::endl;
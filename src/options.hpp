@@ -35,6 +35,10 @@ struct ConfigureOptions {
     fs::path sourcedir;
     fs::path builddir;
     std::unordered_map<std::string, std::string> options;
+    /// Lower each statement as it is parsed, instead of parsing everything first
+    bool streaming = false;
+    /// If set, write a Chrome trace of the configure phases to this file
+    fs::path trace;
 };
 
 /**
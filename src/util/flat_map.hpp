@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Util {
+
+/**
+ * A map with string keys, stored as a vector of pairs sorted by key
+ *
+ * Keyword arguments and dictionaries rarely have more than a handful of
+ * entries. For those a single contiguous allocation and a few string compares
+ * is cheaper than hashing the key and chasing a node per entry, and iteration
+ * is in a stable, sorted order.
+ *
+ * Lookups take a string_view, so looking up a literal does not build a string.
+ * Iterators yield a pair of references with a const key, like the const key of
+ * std::map::value_type, so the order cannot be broken by assigning to a key.
+ */
+template <typename V> class FlatMap {
+    using Storage = std::vector<std::pair<std::string, V>>;
+
+    template <bool Const> class Iterator {
+        using Base = std::conditional_t<Const, typename Storage::const_iterator,
+                                        typename Storage::iterator>;
+        using Mapped = std::conditional_t<Const, const V, V>;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<const std::string, V>;
+        using reference = std::pair<const std::string &, Mapped &>;
+
+        /// Holds the pair of references returned by operator-> alive
+        struct pointer {
+            reference ref;
+            const reference * operator->() const { return &ref; }
+        };
+
+        Iterator() = default;
+        Iterator(const Iterator<false> & other) : it{other.it} {}
+
+        reference operator*() const { return {it->first, it->second}; }
+        pointer operator->() const { return {**this}; }
+
+        Iterator & operator++() {
+            ++it;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            ++it;
+            return prev;
+        }
+
+        bool operator==(const Iterator & other) const { return it == other.it; }
+        bool operator!=(const Iterator & other) const { return it != other.it; }
+
+      private:
+        explicit Iterator(Base b) : it{b} {}
+
+        Base it{};
+
+        friend class FlatMap;
+        friend class Iterator<!Const>;
+    };
+
+  public:
+    using key_type = std::string;
+    using mapped_type = V;
+    using value_type = std::pair<const std::string, V>;
+    using reference = std::pair<const std::string &, V &>;
+    using const_reference = std::pair<const std::string &, const V &>;
+    using size_type = typename Storage::size_type;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatMap() = default;
+    FlatMap(std::initializer_list<value_type> init) {
+        items.reserve(init.size());
+        for (const auto & [k, v] : init) {
+            emplace(k, v);
+        }
+    }
+
+    iterator begin() { return iterator{items.begin()}; }
+    iterator end() { return iterator{items.end()}; }
+    const_iterator begin() const { return const_iterator{items.begin()}; }
+    const_iterator end() const { return const_iterator{items.end()}; }
+
+    bool empty() const { return items.empty(); }
+    size_type size() const { return items.size(); }
+    void reserve(size_type n) { items.reserve(n); }
+    void clear() { items.clear(); }
+
+    iterator find(std::string_view key) {
+        auto it = lower_bound(key);
+        return iterator{it != items.end() && it->first == key ? it : items.end()};
+    }
+
+    const_iterator find(std::string_view key) const {
+        auto it = lower_bound(key);
+        return const_iterator{it != items.end() && it->first == key ? it : items.end()};
+    }
+
+    size_type count(std::string_view key) const { return find(key) != end() ? 1 : 0; }
+
+    V & at(std::string_view key) {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range{"Util::FlatMap::at"};
+        }
+        return it->second;
+    }
+
+    const V & at(std::string_view key) const {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range{"Util::FlatMap::at"};
+        }
+        return it->second;
+    }
+
+    /// Get the value for key, inserting a default constructed one if there isn't one
+    V & operator[](std::string_view key) {
+        auto it = lower_bound(key);
+        if (it == items.end() || it->first != key) {
+            it = items.emplace(it, std::string{key}, V{});
+        }
+        return it->second;
+    }
+
+    /// Insert a value if the key is not already present, like std::map::emplace
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplace(K && key, Args &&... args) {
+        std::string k{std::forward<K>(key)};
+        auto it = lower_bound(k);
+        if (it != items.end() && it->first == k) {
+            return {iterator{it}, false};
+        }
+        it = items.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::move(k)),
+                           std::forward_as_tuple(std::forward<Args>(args)...));
+        return {iterator{it}, true};
+    }
+
+    size_type erase(std::string_view key) {
+        auto it = lower_bound(key);
+        if (it == items.end() || it->first != key) {
+            return 0;
+        }
+        items.erase(it);
+        return 1;
+    }
+
+    iterator erase(const_iterator it) { return iterator{items.erase(it.it)}; }
+
+    bool operator==(const FlatMap & other) const { return items == other.items; }
+    bool operator!=(const FlatMap & other) const { return items != other.items; }
+
+  private:
+    static bool key_less(const typename Storage::value_type & l, std::string_view r) {
+        return l.first < r;
+    }
+
+    typename Storage::iterator lower_bound(std::string_view key) {
+        return std::lower_bound(items.begin(), items.end(), key, key_less);
+    }
+
+    typename Storage::const_iterator lower_bound(std::string_view key) const {
+        return std::lower_bound(items.begin(), items.end(), key, key_less);
+    }
+
+    Storage items;
+};
+
+} // namespace Util
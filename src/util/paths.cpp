@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+#include "paths.hpp"
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Util::Paths {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Table {
+    std::shared_mutex lock{};
+
+    /// Interned paths by their native form. The map is node based, so
+    /// references to the paths are not invalidated by later insertions.
+    std::unordered_map<fs::path::string_type, const fs::path> paths{};
+
+    /// Interned results of relative(), by base, then by path
+    std::unordered_map<fs::path::string_type,
+                       std::unordered_map<fs::path::string_type, const fs::path *>>
+        relative{};
+
+    /// Intern a path, the lock must be held for writing
+    const fs::path & add(const fs::path & p) { return paths.emplace(p.native(), p).first->second; }
+};
+
+Table & table() {
+    static Table t{};
+    return t;
+}
+
+} // namespace
+
+const fs::path & intern(const fs::path & path) {
+    auto & t = table();
+    {
+        std::shared_lock<std::shared_mutex> guard{t.lock};
+        if (const auto p = t.paths.find(path.native()); p != t.paths.end()) {
+            return p->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> guard{t.lock};
+    return t.add(path);
+}
+
+const fs::path & relative(const fs::path & path, const fs::path & base) {
+    auto & t = table();
+    {
+        std::shared_lock<std::shared_mutex> guard{t.lock};
+        if (const auto b = t.relative.find(base.native()); b != t.relative.end()) {
+            if (const auto r = b->second.find(path.native()); r != b->second.end()) {
+                return *r->second;
+            }
+        }
+    }
+
+    // This may touch the filesystem, so don't hold the lock while doing it
+    fs::path result = fs::relative(path, base);
+
+    std::unique_lock<std::shared_mutex> guard{t.lock};
+    const fs::path & interned = t.add(result);
+    return *t.relative[base.native()].emplace(path.native(), &interned).first->second;
+}
+
+} // namespace Util::Paths
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+/**
+ * Interned paths and memoized path conversions
+ *
+ * std::filesystem::relative normalizes both of its arguments and resolves
+ * symlinks, which touches the filesystem. Lowering and the backends convert
+ * the same handful of directories over and over, so the results are kept in a
+ * table shared by all of them, and each conversion is only done once.
+ *
+ * The same directories are also held by many objects, so paths can be
+ * interned, and each distinct path is then stored once.
+ */
+
+#pragma once
+
+#include <filesystem>
+
+namespace Util::Paths {
+
+/**
+ * Get the stored copy of a path, adding it if there isn't one
+ *
+ * Equal paths get the same object, and the returned reference is valid for
+ * the rest of the program.
+ */
+const std::filesystem::path & intern(const std::filesystem::path & path);
+
+/**
+ * Get path relative to base, as std::filesystem::relative does
+ *
+ * The result is interned. Throws std::filesystem::filesystem_error if the
+ * path cannot be made relative.
+ */
+const std::filesystem::path & relative(const std::filesystem::path & path,
+                                       const std::filesystem::path & base);
+
+} // namespace Util::Paths
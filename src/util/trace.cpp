@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+#include "trace.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace Util::Trace {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    const char * category;
+    std::string name;
+    Clock::time_point start;
+    Clock::duration duration;
+    uint32_t tid;
+};
+
+/// Small, stable ids for threads, which are used as the track ids
+uint32_t thread_id() {
+    static std::atomic<uint32_t> next{1};
+    thread_local const uint32_t id = next++;
+    return id;
+}
+
+void write_string(std::ostream & out, std::string_view str) {
+    out << '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[7];
+            std::snprintf(buf, sizeof buf, "\\u%04x", c);
+            out << buf;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+double micros(Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); }
+
+class Tracer {
+  public:
+    ~Tracer() {
+        // If configure failed with an exception, still write out what we have
+        finish();
+    }
+
+    void start(const std::filesystem::path & p) {
+        std::lock_guard l{lock};
+        path = p;
+        epoch = Clock::now();
+        events.clear();
+        active = true;
+    }
+
+    void finish() {
+        if (!active.exchange(false)) {
+            return;
+        }
+        std::lock_guard l{lock};
+        write();
+    }
+
+    void record(Event && e) {
+        std::lock_guard l{lock};
+        events.emplace_back(std::move(e));
+    }
+
+    void name_thread(uint32_t tid, const std::string & name) {
+        std::lock_guard l{lock};
+        threads[tid] = name;
+    }
+
+    std::atomic<bool> active{false};
+
+  private:
+    void write() const {
+        std::ofstream out{path, std::ios::out | std::ios::trunc};
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << std::fixed << std::setprecision(3);
+
+        bool first = true;
+        const auto & separator = [&]() {
+            if (!first) {
+                out << ",\n";
+            }
+            first = false;
+        };
+
+        for (const auto & [tid, name] : threads) {
+            separator();
+            out << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << tid
+                << R"(,"args":{"name":)";
+            write_string(out, name);
+            out << "}}";
+        }
+
+        for (const auto & e : events) {
+            separator();
+            out << R"({"ph":"X","pid":1,"tid":)" << e.tid << R"(,"cat":)";
+            write_string(out, e.category);
+            out << R"(,"name":)";
+            write_string(out, e.name);
+            out << R"(,"ts":)" << micros(e.start - epoch) << R"(,"dur":)" << micros(e.duration)
+                << "}";
+        }
+
+        out << "\n]}\n";
+    }
+
+    std::mutex lock;
+    std::filesystem::path path;
+    Clock::time_point epoch;
+    std::vector<Event> events;
+    std::map<uint32_t, std::string> threads;
+};
+
+Tracer & tracer() {
+    static Tracer t;
+    return t;
+}
+
+} // namespace
+
+void start(const std::filesystem::path & path) {
+    tracer().start(path);
+    set_thread_name("main");
+}
+
+void finish() { tracer().finish(); }
+
+bool enabled() { return tracer().active.load(std::memory_order_relaxed); }
+
+void set_thread_name(const std::string & name) {
+    if (enabled()) {
+        tracer().name_thread(thread_id(), name);
+    }
+}
+
+Scope::Scope(const char * category_, std::string name_)
+    : category{category_}, name{std::move(name_)}, active{enabled()} {
+    if (active) {
+        start = Clock::now();
+    }
+}
+
+Scope::~Scope() {
+    if (active) {
+        const auto end = Clock::now();
+        tracer().record(Event{category, std::move(name), start, end - start, thread_id()});
+    }
+}
+
+} // namespace Util::Trace
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright © 2025 Intel Corporation
+
+/**
+ * Timeline tracing
+ *
+ * Records spans of work and writes them out in the Chrome trace event JSON
+ * format, which can be loaded by chrome://tracing or https://ui.perfetto.dev.
+ * Each thread that records an event gets its own track.
+ *
+ * Tracing is off until `start()` is called, until then a Scope only checks
+ * a single atomic flag. Names that have to be built at runtime can be passed
+ * as a callable, which is only called if tracing is on.
+ * ```c++
+ * Util::Trace::Scope s{"mir", "lower"};
+ * Util::Trace::Scope t{"frontend", [&] { return "parse " + name; }};
+ * ```
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <type_traits>
+
+namespace Util::Trace {
+
+/// Start recording events, which will be written to the given file by `finish()`
+void start(const std::filesystem::path & path);
+
+/// Write out all of the recorded events and stop recording
+void finish();
+
+/// Whether events are currently being recorded
+bool enabled();
+
+/// Name the track of the calling thread
+void set_thread_name(const std::string & name);
+
+/// Records a span covering the lifetime of the object
+class Scope {
+  public:
+    Scope(const char * category, std::string name);
+
+    /// Only build the name with make_name if events are being recorded
+    template <typename F, typename = std::enable_if_t<std::is_invocable_r_v<std::string, F &>>>
+    Scope(const char * category_, F && make_name) : category{category_}, active{enabled()} {
+        if (active) {
+            name = make_name();
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope & operator=(const Scope &) = delete;
+
+  private:
+    const char * category;
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+    bool active;
+};
+
+} // namespace Util::Trace
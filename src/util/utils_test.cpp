@@ -1,10 +1,21 @@
 // SPDX-License-Indentifier: Apache-2.0
 // Copyright © 2024 Intel Corporation
 
+#include "flat_map.hpp"
+#include "paths.hpp"
+#include "trace.hpp"
 #include "utils.hpp"
 
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
 TEST(split, simple) {
     std::vector<std::string> expected{"A", "B", "C"};
     auto && got = Util::split("A B C", " ");
@@ -22,3 +33,98 @@ TEST(join, empty) {
     auto && got = Util::join({}, ";");
     ASSERT_EQ(expected, got);
 }
+
+TEST(trace, events) {
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("mesonpp-trace-test-" + std::to_string(getpid()) + ".json");
+
+    bool named = false;
+    {
+        Util::Trace::Scope s{"test", "not recorded"};
+        Util::Trace::Scope l{"test", [&] {
+                                 named = true;
+                                 return std::string{"lazy"};
+                             }};
+    }
+    EXPECT_FALSE(named);
+    Util::Trace::start(path);
+    {
+        Util::Trace::Scope s{"test", "outer \"quoted\""};
+        Util::Trace::Scope l{"test", [] { return std::string{"lazy"}; }};
+        std::thread t{[] {
+            Util::Trace::set_thread_name("worker");
+            Util::Trace::Scope s{"test", "inner"};
+        }};
+        t.join();
+    }
+    Util::Trace::finish();
+    {
+        Util::Trace::Scope s{"test", "not recorded either"};
+    }
+
+    std::stringstream ss;
+    ss << std::ifstream{path}.rdbuf();
+    const std::string got = ss.str();
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(got.find("not recorded"), std::string::npos);
+    EXPECT_NE(got.find(R"("name":"outer \"quoted\"")"), std::string::npos);
+    EXPECT_NE(got.find(R"("name":"inner")"), std::string::npos);
+    EXPECT_NE(got.find(R"("name":"lazy")"), std::string::npos);
+    EXPECT_NE(got.find(R"("args":{"name":"main"})"), std::string::npos);
+    EXPECT_NE(got.find(R"("args":{"name":"worker"})"), std::string::npos);
+}
+
+TEST(flat_map, sorted) {
+    Util::FlatMap<int> map{{"b", 2}, {"c", 3}};
+    EXPECT_TRUE(map.emplace("a", 1).second);
+    EXPECT_FALSE(map.emplace("b", 4).second);
+    map["d"] = 4;
+
+    std::vector<std::string> keys{};
+    for (const auto & [k, _] : map) {
+        keys.emplace_back(k);
+    }
+    EXPECT_EQ(keys, (std::vector<std::string>{"a", "b", "c", "d"}));
+    EXPECT_EQ(map.at("b"), 2);
+    EXPECT_EQ(map.find("e"), map.end());
+    EXPECT_THROW(map.at("e"), std::out_of_range);
+
+    EXPECT_EQ(map.erase("c"), 1U);
+    EXPECT_EQ(map.count("c"), 0U);
+    EXPECT_EQ(map.size(), 3U);
+}
+
+TEST(flat_map, const_keys) {
+    Util::FlatMap<int> map{{"a", 1}, {"b", 2}};
+    for (auto && [k, v] : map) {
+        static_assert(std::is_const_v<std::remove_reference_t<decltype(k)>>);
+        v *= 10;
+    }
+    EXPECT_EQ(map.at("a"), 10);
+    EXPECT_EQ(map.find("b")->second, 20);
+
+    const auto & cmap = map;
+    Util::FlatMap<int>::const_iterator it = map.find("a");
+    EXPECT_EQ(it, cmap.begin());
+    EXPECT_EQ(map.erase(it)->first, "b");
+}
+
+TEST(paths, relative) {
+    const auto & got = Util::Paths::relative("/mesonpp-test/lib/foo", "/mesonpp-test/share");
+    EXPECT_EQ(got, "../lib/foo");
+
+    // The same conversion gets the same stored result
+    EXPECT_EQ(&Util::Paths::relative("/mesonpp-test/lib/foo", "/mesonpp-test/share"), &got);
+    EXPECT_EQ(Util::Paths::relative("/mesonpp-test/lib/foo", "/mesonpp-test/lib"), "foo");
+
+    // Results are interned, so equal results are one object
+    EXPECT_EQ(&Util::Paths::relative("/mesonpp-test/x/lib/foo", "/mesonpp-test/x/share"), &got);
+}
+
+TEST(paths, intern) {
+    const auto & a = Util::Paths::intern("/mesonpp-test/a");
+    EXPECT_EQ(a, "/mesonpp-test/a");
+    EXPECT_EQ(&Util::Paths::intern(std::filesystem::path{"/mesonpp-test"} / "a"), &a);
+    EXPECT_NE(&Util::Paths::intern("/mesonpp-test/b"), &a);
+}